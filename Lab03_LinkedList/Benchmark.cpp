@@ -0,0 +1,162 @@
+#include <iostream>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+
+#include "MyLinkedList_w125t659.h"
+
+using namespace std;
+
+// the number of elements in the benchmarked lists
+static const int N = 1000000;
+
+// runs f once and returns the elapsed time in milliseconds
+template <typename Func>
+double timeIt(Func f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    auto stop = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(stop - start).count();
+}
+
+// peak resident memory of the process so far, in MB
+double peakMemoryMB()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+// an element whose copy throws once copies runs out
+struct ThrowingCopy
+{
+    static int copies;
+    int value;
+
+    ThrowingCopy(int v = 0) :
+        value{v}
+    { }
+
+    ThrowingCopy(const ThrowingCopy& rhs) :
+        value{rhs.value}
+    {
+        if (copies-- <= 0)
+            throw runtime_error("copy failed");
+    }
+
+    ThrowingCopy& operator=(const ThrowingCopy& rhs) = default;
+};
+
+int ThrowingCopy::copies = 1000;
+
+// checks that the node blocks of bulk copies are freed once their elements are popped,
+// and that a copy that throws leaves the list as it was
+void checkBlocks()
+{
+    cout << "Node blocks" << endl;
+
+    MyLinkedList<int> src;
+    for (int i = 0; i < 1000; ++ i)
+        src.push_back(i);
+
+    // every round copies 1000 ints into a new block and pops them all; the peak stays flat
+    // only if each block is freed with its last node, and grows by about 32 bytes per node otherwise
+    double before = peakMemoryMB();
+    MyLinkedList<int> l;
+    for (int round = 0; round < 1000; ++ round)
+    {
+        l = src;
+        while (!l.empty())
+            l.pop_back();
+    }
+    cout << "  1000 rounds of assign and pop:\tpeak memory +" << peakMemoryMB() - before << " MB" << endl;
+
+    MyLinkedList<ThrowingCopy> t;
+    t.push_back(ThrowingCopy(-1));
+    MyLinkedList<ThrowingCopy> big;
+    for (int i = 0; i < 100; ++ i)
+        big.push_back(ThrowingCopy(i));
+    ThrowingCopy::copies = 50;
+    bool thrown = false;
+    try
+    {
+        t = big;
+    }
+    catch (const runtime_error&)
+    {
+        thrown = true;
+    }
+    // the first element was assigned in place before the copy of the rest threw
+    if (!thrown || t.size() != 1 || t.front().value != 0)
+        cout << "  ERROR: a copy that throws changed the length of the list" << endl;
+}
+
+// copy and clear one element at a time, one allocation and one free per node: the baseline for
+// the block copy and clear of MyLinkedList
+template <typename DataType>
+void naiveCopy(const MyLinkedList<DataType>& src, MyLinkedList<DataType>& dst)
+{
+    for (auto &x : src)
+        dst.push_back(x);
+}
+
+template <typename DataType>
+void naiveClear(MyLinkedList<DataType>& l)
+{
+    while (!l.empty())
+        l.pop_front();
+}
+
+template <typename DataType>
+void benchmark(const string& name, const MyLinkedList<DataType>& src)
+{
+    cout << name << " (" << src.size() << " elements)" << endl;
+
+    {
+        MyLinkedList<DataType> l;
+        double t_copy = timeIt([&]{ naiveCopy(src, l); });
+        double t_clear = timeIt([&]{ naiveClear(l); });
+        cout << "  per-node push_back copy:\t" << t_copy << " ms" << endl;
+        cout << "  per-node pop_front clear:\t" << t_clear << " ms" << endl;
+    }
+
+    {
+        MyLinkedList<DataType> *l = nullptr;
+        double t_copy = timeIt([&]{ l = new MyLinkedList<DataType>(src); });
+        double t_clear = timeIt([&]{ l->clear(); });
+        cout << "  bulk copy constructor:\t" << t_copy << " ms" << endl;
+        cout << "  single pass clear:\t\t" << t_clear << " ms" << endl;
+
+        // the emptied list keeps its sentinels; assignment has to allocate everything again
+        double t_assign = timeIt([&]{ *l = src; });
+        cout << "  copy assignment (empty):\t" << t_assign << " ms" << endl;
+
+        // assigning over a list of the same length only overwrites the data in place
+        t_assign = timeIt([&]{ *l = src; });
+        cout << "  copy assignment (reuse):\t" << t_assign << " ms" << endl;
+
+        if (l->size() != src.size() || l->front() != src.front() || l->back() != src.back())
+            cout << "  ERROR: copy does not match the source list" << endl;
+        delete l;
+    }
+}
+
+int main()
+{
+    checkBlocks();
+
+    MyLinkedList<int> ints;
+    MyLinkedList<string> strings;
+    for (int i = 0; i < N; ++ i)
+    {
+        ints.push_back(i);
+        strings.push_back("element_" + to_string(i));
+    }
+
+    benchmark("MyLinkedList<int>", ints);
+    benchmark("MyLinkedList<string>", strings);
+
+    return 0;
+}
@@ -3,34 +3,51 @@
 
 #include <algorithm>
 #include <iostream>
+#include <new>
 
 template <typename DataType>
 class MyLinkedList
 {
   private:
+
+    struct NodeBlock;
     
     struct Node
     {
         DataType  data;
         Node   *prev;
         Node   *next;
+        NodeBlock *block;   // the NodeBlock the node lives in; nullptr if it has an allocation of its own
         
-        Node(const DataType &d = DataType{ }, Node *p = nullptr, Node *n = nullptr) : 
+        Node(const DataType &d = DataType{ }, Node *p = nullptr, Node *n = nullptr, NodeBlock *b = nullptr) : 
         data{d}, 
         prev{p}, 
-        next{n} 
+        next{n},
+        block{b}
         { }
 
-        Node(DataType&& d, Node* p = nullptr, Node* n = nullptr) : 
+        Node(DataType&& d, Node* p = nullptr, Node* n = nullptr, NodeBlock *b = nullptr) : 
         data{std::move(d)}, 
         prev{p}, 
-        next{n} 
+        next{n},
+        block{b}
         { }
     };
 
+    // a contiguous chunk of nodes allocated at once by a bulk copy
+    // the memory is returned as soon as the last of its nodes is destructed
+    struct NodeBlock
+    {
+        Node      *nodes;
+        int        live;    // the nodes of the block that are not destructed yet
+        NodeBlock *prev;
+        NodeBlock *next;
+    };
+
     int theSize;        // the number of elements that the linked list is currently holding
     Node *head;         // pointer to the head node; does not hold real data
     Node *tail;         // pointer to the tail note; does not hold real data
+    NodeBlock *blocks;  // the node blocks owned by this list
 
     void init( )
     { 
@@ -39,10 +56,41 @@ class MyLinkedList
         tail = new Node;
         head->next = tail;
         tail->prev = head;
+        blocks = nullptr;
 
         return;
     }
 
+    // releases a single node; block nodes are only destructed as their memory belongs to the block,
+    // which is freed along with its last node
+    void destroyNode(Node *p)
+    {
+        NodeBlock *b = p->block;
+        if (b == nullptr)
+        {
+            delete p;
+            return;
+        }
+
+        p->~Node();
+        if (-- b->live == 0)
+            freeBlock(b);
+    }
+
+    // unlinks a node block from the blocks of this list and returns its memory
+    void freeBlock(NodeBlock *b)
+    {
+        if (b->prev != nullptr)
+            b->prev->next = b->next;
+        else
+            blocks = b->next;
+        if (b->next != nullptr)
+            b->next->prev = b->prev;
+
+        ::operator delete(b->nodes);
+        delete b;
+    }
+
   public:
 
     // define the const_iterator class
@@ -179,6 +227,49 @@ class MyLinkedList
         // don't need to overload operator= and operator!= as they should behave the same as in const_iterator
     };
 
+  private:
+
+    // copies the n data elements in [from, to) to the end of the list
+    // all the nodes are carved out of one block and constructed first, then linked in a single pass,
+    // so that a copy that throws leaves the list as it was
+    void copyBack(const_iterator from, const_iterator to, int n)
+    {
+        if (n <= 0)
+            return;
+
+        NodeBlock *block = new NodeBlock{nullptr, 0, nullptr, nullptr};
+        try
+        {
+            block->nodes = static_cast<Node*>(::operator new(n * sizeof(Node)));
+            for (; from != to; ++from, ++block->live)
+                new (block->nodes + block->live) Node{*from, nullptr, nullptr, block};
+        }
+        catch (...)
+        {
+            for (int i = 0; i < block->live; i++)
+                block->nodes[i].~Node();
+            ::operator delete(block->nodes);
+            delete block;
+            throw;
+        }
+
+        block->next = blocks;
+        if (blocks != nullptr)
+            blocks->prev = block;
+        blocks = block;
+
+        Node *last = tail->prev;
+        for (Node *p = block->nodes; p != block->nodes + block->live; ++p)
+        {
+            p->prev = last;
+            last->next = p;
+            last = p;
+        }
+        last->next = tail;
+        tail->prev = last;
+        theSize += block->live;
+    }
+
   // defining the MyLinkedList class methods
   public:
 
@@ -192,22 +283,20 @@ class MyLinkedList
     MyLinkedList(const MyLinkedList& rhs)
     { 
         init();
-
-        for (auto &x : rhs)
-        {
-            push_back(x);
-        }
+        copyBack(rhs.begin(), rhs.end(), rhs.size());
     }
 
     // move constructor
     MyLinkedList (MyLinkedList&& rhs) :
     theSize(rhs.theSize),
     head(rhs.head),
-    tail(rhs.tail)
+    tail(rhs.tail),
+    blocks(rhs.blocks)
     { 
         rhs.theSize = 0;
         rhs.head = nullptr;
         rhs.tail = nullptr;
+        rhs.blocks = nullptr;
     }
 
     // destructor
@@ -219,10 +308,33 @@ class MyLinkedList
     }
 
     // copy assignment
+    // reuses the existing nodes and only allocates (or frees) the difference in length
     MyLinkedList & operator= (const MyLinkedList& rhs)
     { 
-        MyLinkedList copy = rhs;
-        std::swap(*this, copy);
+        if (this == &rhs)
+            return *this;
+
+        if (head == nullptr)
+            init();
+
+        if (rhs.empty())
+        {
+            clear();
+            return *this;
+        }
+
+        iterator itr = begin();
+        const_iterator ritr = rhs.begin();
+        for (; itr != end() && ritr != rhs.end(); ++itr, ++ritr)
+        {
+            *itr = *ritr;
+        }
+
+        if (ritr == rhs.end())
+            erase(itr, end());
+        else
+            copyBack(ritr, rhs.end(), rhs.size() - size());
+
         return *this;
     }
   
@@ -232,6 +344,7 @@ class MyLinkedList
         std::swap(theSize, rhs.theSize);
         std::swap(head, rhs.head);
         std::swap(tail, rhs.tail);
+        std::swap(blocks, rhs.blocks);
 
         return *this;
     }
@@ -270,10 +383,23 @@ class MyLinkedList
     }
 
     // deletes all nodes excepts the head and tail
+    // walks the list once without relinking the neighbours of nodes that are about to go away
     void clear( )
     {
-        while(!empty())
-            pop_front();
+        if (head == nullptr)
+            return;
+
+        Node *p = head->next;
+        while (p != tail)
+        {
+            Node *next = p->next;
+            destroyNode(p);
+            p = next;
+        }
+
+        head->next = tail;
+        tail->prev = head;
+        theSize = 0;
     }
 
     // return the first data element as mutable
@@ -326,7 +452,7 @@ class MyLinkedList
         iterator retVal{p->next};
         p->prev->next = p->next;
         p->next->prev = p->prev;
-        delete p;
+        destroyNode(p);
         theSize--;
 
         return retVal;
@@ -389,6 +515,33 @@ class MyLinkedList
         std::swap(head, tail);
     }
  
+    // move the data element pointed by itr out of rlist and insert it before pos, relinking its node
+    // a node that lives in a block of rlist is moved into a node of its own, as the block stays with rlist
+    // return iterator pointing to the moved data element
+    iterator splice(iterator pos, MyLinkedList<DataType>& rlist, iterator itr)
+    {
+        Node *p = itr.current;
+        if (p->block != nullptr)
+        {
+            iterator moved = insert(pos, std::move(p->data));
+            rlist.erase(itr);
+            return moved;
+        }
+
+        p->prev->next = p->next;
+        p->next->prev = p->prev;
+        rlist.theSize--;
+
+        Node *q = pos.current;
+        p->prev = q->prev;
+        p->next = q;
+        q->prev->next = p;
+        q->prev = p;
+        theSize++;
+
+        return iterator(p);
+    }
+
     // append a linked list to the end of the current one
     MyLinkedList<DataType>& appendList(MyLinkedList<DataType>&& rlist) 
     {
@@ -400,10 +553,23 @@ class MyLinkedList
     
         tail = rlist.tail;
         theSize += rlist.theSize;
+
+        // the appended nodes may live in rlist's blocks, so take those over as well
+        if (rlist.blocks != nullptr)
+        {
+            NodeBlock *last = rlist.blocks;
+            while (last->next != nullptr)
+                last = last->next;
+            last->next = blocks;
+            if (blocks != nullptr)
+                blocks->prev = last;
+            blocks = rlist.blocks;
+        }
     
         rlist.head = nullptr;
         rlist.tail = nullptr;
         rlist.theSize = 0;
+        rlist.blocks = nullptr;
     
         return *this;
     }
@@ -0,0 +1,648 @@
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+
+#include "MyVector_w125t659.h"
+#include "MyStack_w125t659.h"
+#include "MyQueue_w125t659.h"
+#include "MySPSCQueue_w125t659.h"
+#include "MyMPMCQueue_w125t659.h"
+#include "MyDeque_w125t659.h"
+#include "MyThreadPool_w125t659.h"
+
+using namespace std;
+
+// every heap allocation made by the program is counted here
+static atomic<size_t> allocations(0);
+
+// every replaced operator new and delete below goes through these two
+// they are kept out of line so that the compiler does not see free() called on memory from operator new,
+// which -Wall reports as a mismatched deallocation
+__attribute__((noinline)) void * countedAllocate(size_t n)
+{
+    ++ allocations;
+    void *p = malloc(n == 0 ? 1 : n);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void countedFree(void *p) noexcept
+{
+    free(p);
+}
+
+void * operator new(size_t n)
+{
+    return countedAllocate(n);
+}
+
+void * operator new[](size_t n)
+{
+    return countedAllocate(n);
+}
+
+void operator delete(void *p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+// runs f once and returns the elapsed time in milliseconds
+template <typename Func>
+double timeIt(Func f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    auto stop = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(stop - start).count();
+}
+
+// the previous stack layout: a MyVector base that is never used plus a MyVector member
+template <typename DataType>
+class VectorStack : private MyVector<DataType>
+{
+  private:
+    MyVector<DataType> stackData;
+
+  public:
+    void push(DataType && x)     { stackData.push_back(x); }
+    void pop(void)               { stackData.pop_back(); }
+    const DataType & top() const { return stackData.back(); }
+};
+
+// prints the time, throughput and allocation count of one benchmark run
+void report(const string& name, size_t ops, double ms, size_t allocs)
+{
+    cout << "  " << name << ":\t" << ms << " ms\t"
+         << ops / ms / 1000.0 << " M ops/s\t"
+         << allocs << " allocations" << endl;
+}
+
+// throughput and allocations of push/pop pairs
+void benchStack(size_t pairs)
+{
+    cout << "MyStack push/pop (" << pairs << " pairs)" << endl;
+
+    {
+        size_t allocs = allocations;
+        long long sum = 0;
+        double ms = timeIt([&]{
+            VectorStack<long long> s;
+            for (size_t i = 0; i < pairs; ++ i)
+            {
+                s.push(static_cast<long long>(i));
+                sum += s.top();
+                s.pop();
+            }
+        });
+        report("MyVector based (long long)", pairs, ms, allocations - allocs);
+        if (sum < 0) cout << sum << endl;
+    }
+
+    {
+        size_t allocs = allocations;
+        long long sum = 0;
+        double ms = timeIt([&]{
+            MyStack<long long> s;
+            for (size_t i = 0; i < pairs; ++ i)
+            {
+                s.push(static_cast<long long>(i));
+                sum += s.pop_and_get();
+            }
+        });
+        report("MyStack (long long)\t", pairs, ms, allocations - allocs);
+        if (sum < 0) cout << sum << endl;
+    }
+
+    // strings long enough to defeat the small string optimization, so copies allocate
+    size_t string_pairs = pairs / 10;
+    const string payload(64, 'x');
+    cout << "MyStack push/pop (" << string_pairs << " pairs of 64 byte strings)" << endl;
+
+    {
+        size_t allocs = allocations;
+        size_t len = 0;
+        double ms = timeIt([&]{
+            VectorStack<string> s;
+            for (size_t i = 0; i < string_pairs; ++ i)
+            {
+                string x = payload;
+                s.push(std::move(x));
+                len += s.top().size();
+                s.pop();
+            }
+        });
+        report("MyVector based (string)", string_pairs, ms, allocations - allocs);
+        if (len == 0) cout << len << endl;
+    }
+
+    {
+        size_t allocs = allocations;
+        size_t len = 0;
+        double ms = timeIt([&]{
+            MyStack<string> s;
+            for (size_t i = 0; i < string_pairs; ++ i)
+            {
+                string x = payload;
+                s.push(std::move(x));
+                len += s.pop_and_get().size();
+            }
+        });
+        report("MyStack (string)\t", string_pairs, ms, allocations - allocs);
+        if (len == 0) cout << len << endl;
+    }
+}
+
+// the previous queue layout: dequeue compacts the whole vector once half of it has been consumed
+template <typename DataType>
+class VectorQueue
+{
+  private:
+    size_t dataStart = 0, dataEnd = 0;
+    MyVector<DataType> queueData;
+
+  public:
+    void enqueue(const DataType & x)
+    {
+        queueData.push_back(x);
+        dataEnd++;
+    }
+
+    void dequeue(void)
+    {
+        dataStart++;
+        if (dataStart > queueData.size() / 2) {
+            MyVector<DataType> newQueue;
+            for (size_t i = dataStart; i < dataEnd; ++i) {
+                newQueue.push_back(queueData[i]);
+            }
+            std::swap(queueData, newQueue);
+            dataEnd = dataEnd - dataStart;
+            dataStart = 0;
+        }
+    }
+
+    const DataType & front(void) const { return queueData[dataStart]; }
+};
+
+// keeps the queue at a steady depth and times every single dequeue
+// prints a histogram with power-of-two nanosecond buckets plus the tail percentiles
+template <typename Queue>
+void queueLatency(const string& name, size_t depth, size_t ops)
+{
+    Queue q;
+    for (size_t i = 0; i < depth; ++ i)
+        q.enqueue(static_cast<long long>(i));
+
+    vector<long long> samples(ops);
+    long long sum = 0;
+    for (size_t i = 0; i < ops; ++ i)
+    {
+        q.enqueue(static_cast<long long>(depth + i));
+        auto start = chrono::steady_clock::now();
+        sum += q.front();
+        q.dequeue();
+        auto stop = chrono::steady_clock::now();
+        samples[i] = chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
+    }
+    if (sum < 0) cout << sum << endl;
+
+    vector<size_t> buckets(40, 0);
+    for (long long ns : samples)
+    {
+        size_t b = 0;
+        while (b + 1 < buckets.size() && (1LL << (b + 1)) <= ns)
+            ++ b;
+        ++ buckets[b];
+    }
+
+    sort(samples.begin(), samples.end());
+    cout << "  " << name << ": p50 " << samples[ops / 2] << " ns, p99 " << samples[ops * 99 / 100]
+         << " ns, p99.9 " << samples[ops * 999 / 1000] << " ns, max " << samples.back() << " ns" << endl;
+    for (size_t b = 0; b < buckets.size(); ++ b)
+    {
+        if (buckets[b] != 0)
+            cout << "    [" << (1LL << b) << ", " << (1LL << (b + 1)) << ") ns\t" << buckets[b] << endl;
+    }
+}
+
+// prints the throughput of one producer/consumer run
+void reportMessages(const string& name, size_t messages, double ms)
+{
+    cout << "  " << name << ":\t" << ms << " ms\t" << messages / ms / 1000.0 << " M msgs/s" << endl;
+}
+
+// one reader thread feeding one processing thread through a bounded queue
+void benchSPSC(size_t messages)
+{
+    const size_t BATCH = 64;
+    cout << "Producer/consumer, 2 threads (" << messages << " messages)" << endl;
+
+    {
+        MyQueue<long long> q;
+        mutex m;
+        long long sum = 0;
+        double ms = timeIt([&]{
+            thread producer([&]{
+                for (size_t i = 0; i < messages; ++ i)
+                {
+                    lock_guard<mutex> lock(m);
+                    q.enqueue(static_cast<long long>(i));
+                }
+            });
+            for (size_t received = 0; received < messages; )
+            {
+                unique_lock<mutex> lock(m);
+                if (!q.empty())
+                {
+                    sum += q.front();
+                    q.dequeue();
+                    ++ received;
+                }
+                else
+                {
+                    lock.unlock();
+                    this_thread::yield();
+                }
+            }
+            producer.join();
+        });
+        reportMessages("mutex + MyQueue\t", messages, ms);
+        if (sum < 0) cout << sum << endl;
+    }
+
+    {
+        MySPSCQueue<long long> q(4096);
+        long long sum = 0;
+        double ms = timeIt([&]{
+            thread producer([&]{
+                for (size_t i = 0; i < messages; ++ i)
+                {
+                    while (!q.enqueue(static_cast<long long>(i)))
+                        this_thread::yield();
+                }
+            });
+            long long x;
+            for (size_t received = 0; received < messages; )
+            {
+                if (q.dequeue(x))
+                {
+                    sum += x;
+                    ++ received;
+                }
+                else
+                {
+                    this_thread::yield();
+                }
+            }
+            producer.join();
+        });
+        reportMessages("MySPSCQueue\t", messages, ms);
+        if (sum != static_cast<long long>(messages) * (static_cast<long long>(messages) - 1) / 2)
+            cout << "  ERROR: lost or duplicated messages" << endl;
+    }
+
+    {
+        MySPSCQueue<long long> q(4096);
+        long long sum = 0;
+        double ms = timeIt([&]{
+            thread producer([&]{
+                long long batch[BATCH];
+                for (size_t i = 0; i < messages; )
+                {
+                    size_t n = std::min(BATCH, messages - i);
+                    for (size_t j = 0; j < n; ++ j)
+                        batch[j] = static_cast<long long>(i + j);
+                    for (size_t sent = 0; sent < n; )
+                    {
+                        size_t k = q.enqueue_bulk(batch + sent, n - sent);
+                        if (k == 0)
+                            this_thread::yield();
+                        sent += k;
+                    }
+                    i += n;
+                }
+            });
+            long long batch[BATCH];
+            for (size_t received = 0; received < messages; )
+            {
+                size_t n = q.dequeue_bulk(batch, BATCH);
+                if (n == 0)
+                    this_thread::yield();
+                for (size_t j = 0; j < n; ++ j)
+                    sum += batch[j];
+                received += n;
+            }
+            producer.join();
+        });
+        reportMessages("MySPSCQueue, bulk 64", messages, ms);
+        if (sum != static_cast<long long>(messages) * (static_cast<long long>(messages) - 1) / 2)
+            cout << "  ERROR: lost or duplicated messages" << endl;
+    }
+}
+
+// the baseline for many producers and consumers: MyQueue guarded by a single mutex
+template <typename DataType>
+class LockedQueue
+{
+  private:
+    MyQueue<DataType> q;
+    mutex m;
+
+  public:
+    bool enqueue(const DataType & x)
+    {
+        lock_guard<mutex> lock(m);
+        q.enqueue(x);
+        return true;
+    }
+
+    bool dequeue(DataType & x)
+    {
+        lock_guard<mutex> lock(m);
+        if (q.empty())
+            return false;
+        x = q.front();
+        q.dequeue();
+        return true;
+    }
+};
+
+// the non-blocking dequeue of both queues; spins politely while the queue is empty
+template <typename Queue>
+bool consume(Queue & q, long long & x)
+{
+    if (q.dequeue(x))
+        return true;
+    this_thread::yield();
+    return false;
+}
+
+// the MPMC queue sleeps instead; the timeout lets consumers notice that all messages are gone
+bool consume(MyMPMCQueue<long long> & q, long long & x)
+{
+    return q.wait_dequeue_for(x, chrono::milliseconds(1));
+}
+
+// moves messages from several producers to several consumers and checks that none got lost
+template <typename Queue>
+void producersConsumers(const string& name, size_t producers, size_t consumers, size_t messages)
+{
+    Queue q;
+    atomic<size_t> received(0);
+    atomic<long long> sum(0);
+
+    double ms = timeIt([&]{
+        vector<thread> threads;
+        for (size_t p = 0; p < producers; ++ p)
+        {
+            threads.emplace_back([&, p]{
+                for (size_t i = p; i < messages; i += producers)
+                {
+                    while (!q.enqueue(static_cast<long long>(i)))
+                        this_thread::yield();
+                }
+            });
+        }
+        for (size_t c = 0; c < consumers; ++ c)
+        {
+            threads.emplace_back([&]{
+                long long local = 0;
+                long long x;
+                while (received.load(memory_order_relaxed) < messages)
+                {
+                    if (consume(q, x))
+                    {
+                        local += x;
+                        received.fetch_add(1, memory_order_relaxed);
+                    }
+                }
+                sum += local;
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+    });
+
+    cout << "  " << name << " " << producers << "P/" << consumers << "C:\t" << ms << " ms\t"
+         << messages / ms / 1000.0 << " M msgs/s" << endl;
+    if (sum != static_cast<long long>(messages) * (static_cast<long long>(messages) - 1) / 2)
+        cout << "  ERROR: lost or duplicated messages" << endl;
+}
+
+// 1..N producers and consumers, N being the number of hardware threads
+void benchMPMC(size_t messages)
+{
+    size_t n = std::max<size_t>(thread::hardware_concurrency(), 2);
+    cout << "Producers/consumers (" << messages << " messages)" << endl;
+    for (size_t k = 1; k <= n; k *= 2)
+    {
+        producersConsumers<LockedQueue<long long> >("mutex + MyQueue", k, k, messages);
+        producersConsumers<MyMPMCQueue<long long> >("MyMPMCQueue\t", k, k, messages);
+    }
+}
+
+// fills a container with n elements and drains it again, once in LIFO and once in FIFO order
+void benchDeque(size_t n)
+{
+    cout << "Fill and drain (" << n << " elements)" << endl;
+
+    long long sum = 0;
+    size_t allocs = allocations;
+    double ms = timeIt([&]{
+        MyStack<long long> s;
+        for (size_t i = 0; i < n; ++ i)
+            s.push(static_cast<long long>(i));
+        while (!s.empty())
+            sum += s.pop_and_get();
+    });
+    report("LIFO MyStack\t", n, ms, allocations - allocs);
+
+    allocs = allocations;
+    ms = timeIt([&]{
+        MyDeque<long long> d;
+        for (size_t i = 0; i < n; ++ i)
+            d.push_back(static_cast<long long>(i));
+        while (!d.empty())
+            sum += d.pop_back_and_get();
+    });
+    report("LIFO MyDeque\t", n, ms, allocations - allocs);
+
+    allocs = allocations;
+    ms = timeIt([&]{
+        MyQueue<long long> q;
+        for (size_t i = 0; i < n; ++ i)
+            q.enqueue(static_cast<long long>(i));
+        while (!q.empty())
+        {
+            sum += q.front();
+            q.dequeue();
+        }
+    });
+    report("FIFO MyQueue\t", n, ms, allocations - allocs);
+
+    allocs = allocations;
+    ms = timeIt([&]{
+        MyDeque<long long> d;
+        for (size_t i = 0; i < n; ++ i)
+            d.push_back(static_cast<long long>(i));
+        while (!d.empty())
+            sum += d.pop_front_and_get();
+    });
+    report("FIFO MyDeque\t", n, ms, allocations - allocs);
+
+    // a queue sliding along at a constant depth; the deque recycles its blocks
+    allocs = allocations;
+    ms = timeIt([&]{
+        MyDeque<long long> d;
+        for (size_t i = 0; i < n; ++ i)
+        {
+            d.push_back(static_cast<long long>(i));
+            if (d.size() > 1000)
+                sum += d.pop_front_and_get();
+        }
+    });
+    report("sliding MyDeque\t", n, ms, allocations - allocs);
+
+    // random access
+    MyDeque<long long> d;
+    for (size_t i = 0; i < n; ++ i)
+        d.push_front(static_cast<long long>(i));
+    ms = timeIt([&]{
+        size_t idx = 1;
+        for (size_t i = 0; i < n; ++ i)
+        {
+            idx = (idx * 2654435761u + 12345) % n;
+            sum += d[idx];
+        }
+    });
+    report("random d[i]\t", n, ms, 0);
+
+    if (sum < 0) cout << sum << endl;
+}
+
+// plain recursive fibonacci, the serial baseline and the leaves of the parallel version
+long long fib(int n)
+{
+    return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+// recursive fork-join: one half runs as a task, the other half on the current thread
+long long parallelFib(MyThreadPool & pool, int n)
+{
+    if (n < 20)
+        return fib(n);
+
+    long long a = 0;
+    MyTaskGroup group(pool);
+    group.run([&pool, &a, n]{ a = parallelFib(pool, n - 1); });
+    long long b = parallelFib(pool, n - 2);
+    group.wait();
+    return a + b;
+}
+
+// fork-join scaling from one worker up to the number of hardware threads
+void benchThreadPool(int n, size_t elements)
+{
+    cout << "Fork-join fib(" << n << ") and parallel_for over " << elements << " elements" << endl;
+
+    long long expected = 0;
+    double ms = timeIt([&]{ expected = fib(n); });
+    cout << "  serial fib\t\t" << ms << " ms" << endl;
+
+    vector<double> data(elements);
+    double serialSum = 0;
+    ms = timeIt([&]{
+        for (size_t i = 0; i < elements; ++ i)
+        {
+            data[i] = static_cast<double>(i % 1000) * 0.5;
+            serialSum += data[i];
+        }
+    });
+    cout << "  serial for\t\t" << ms << " ms" << endl;
+
+    size_t maxThreads = std::max<size_t>(thread::hardware_concurrency(), 2);
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        MyThreadPool pool(threads);
+
+        long long result = 0;
+        ms = timeIt([&]{ result = parallelFib(pool, n); });
+        cout << "  " << threads << " worker(s) fib\t" << ms << " ms" << endl;
+        if (result != expected)
+            cout << "  ERROR: parallel fib returned " << result << endl;
+
+        // each block of 64K indices writes its own partial sum
+        const size_t BLOCK = 1 << 16;
+        vector<double> partial((elements + BLOCK - 1) / BLOCK, 0.0);
+        ms = timeIt([&]{
+            pool.parallel_for(0, partial.size(), [&](size_t b){
+                double sum = 0;
+                size_t end = std::min(elements, (b + 1) * BLOCK);
+                for (size_t i = b * BLOCK; i < end; ++ i)
+                {
+                    data[i] = static_cast<double>(i % 1000) * 0.5;
+                    sum += data[i];
+                }
+                partial[b] = sum;
+            });
+        });
+        double parallelSum = 0;
+        for (double p : partial)
+            parallelSum += p;
+        cout << "  " << threads << " worker(s) for\t" << ms << " ms" << endl;
+        // the partial sums are added in another order; only tiny differences are expected
+        if (parallelSum - serialSum > 1e-6 * serialSum || serialSum - parallelSum > 1e-6 * serialSum)
+            cout << "  ERROR: parallel_for sum " << parallelSum << " != " << serialSum << endl;
+
+        // plain submit + wait from outside the pool
+        atomic<size_t> done(0);
+        for (size_t i = 0; i < 1000; ++ i)
+            pool.submit([&done]{ done.fetch_add(1); });
+        pool.wait();
+        if (done != 1000)
+            cout << "  ERROR: wait() returned before all tasks finished" << endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // the number of stack push/pop pairs; can be reduced from the command line for quick runs
+    size_t pairs = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000000;
+    benchStack(pairs);
+
+    size_t depth = 100000;
+    size_t ops = std::max<size_t>(pairs / 100, 1000);
+    cout << "MyQueue dequeue latency (depth " << depth << ", " << ops << " dequeues)" << endl;
+    queueLatency<VectorQueue<long long> >("MyVector based", depth, ops);
+    queueLatency<MyQueue<long long> >("ring buffer\t", depth, ops);
+
+    benchDeque(pairs / 10);
+    benchSPSC(pairs / 10);
+    benchMPMC(pairs / 20);
+    benchThreadPool(36, pairs / 2);
+
+    return 0;
+}
@@ -0,0 +1,343 @@
+#ifndef __MYDEQUE_H__
+#define __MYDEQUE_H__
+
+#include <iostream>
+#include <algorithm>
+#include <new>
+#include <utility>
+
+// the smallest power of two n for which n elements of elemSize bytes fill 512 bytes
+constexpr size_t dequeBlockElements(size_t elemSize, size_t n = 1)
+{
+    return n * elemSize >= 512 ? n : dequeBlockElements(elemSize, n * 2);
+}
+
+// a double-ended queue stored as a map of fixed-size blocks
+// both ends grow and shrink in O(1); growing only ever copies block pointers, elements never move
+template <typename DataType>
+class MyDeque
+{
+  public:
+
+    // elements per block; a power of two filling 512 bytes, but at least 16 elements
+    static const size_t BLOCK_SIZE = dequeBlockElements(sizeof(DataType)) < 16 ? 16 : dequeBlockElements(sizeof(DataType));
+
+  private:
+    DataType **blockMap;    // pointers to the blocks; unused map entries are null
+    size_t mapCapacity;     // number of entries in blockMap
+    size_t dataStart;       // position of the first element, counted in slots from the start of blockMap[0]
+    size_t theSize;         // the number of data elements the deque is currently holding
+    DataType *spareBlock;   // one emptied block kept around so a deque bouncing on a block edge does not reallocate
+
+    static const size_t INIT_MAP_CAPACITY = 8;
+
+    // allocates uninitialized storage for one block
+    DataType * newBlock()
+    {
+        if (spareBlock != nullptr){
+            DataType *b = spareBlock;
+            spareBlock = nullptr;
+            return b;
+        }
+        return static_cast<DataType*>(::operator new(BLOCK_SIZE * sizeof(DataType)));
+    }
+
+    // takes back a block that no longer holds any element
+    void freeBlock(DataType *b)
+    {
+        if (spareBlock == nullptr)
+            spareBlock = b;
+        else
+            ::operator delete(b);
+    }
+
+    // the slot of position pos
+    DataType * slot(size_t pos) const
+    {
+        return &blockMap[pos / BLOCK_SIZE][pos % BLOCK_SIZE];
+    }
+
+    // makes sure there are at least `front` free map entries before the first used block
+    // and `back` free map entries after the last used block; only block pointers are moved
+    // every map entry outside the used blocks is null, so nothing is lost by clearing them
+    void reserveMap(size_t front, size_t back)
+    {
+        size_t firstBlock = dataStart / BLOCK_SIZE;
+        size_t usedBlocks = theSize == 0 ? 1 : (dataStart + theSize - 1) / BLOCK_SIZE - firstBlock + 1;
+        if (firstBlock >= front && mapCapacity - firstBlock - usedBlocks >= back)
+            return;
+
+        size_t needed = usedBlocks + front + back;
+        size_t newCapacity = mapCapacity;
+        // recenter in place while the map is at most half full, otherwise double it
+        while (newCapacity < 2 * needed)
+            newCapacity *= 2;
+
+        size_t newFirst = front + (newCapacity - needed) / 2;
+        DataType **used = blockMap + firstBlock;
+
+        if (newCapacity != mapCapacity){
+            DataType **newMap = new DataType*[newCapacity];
+            std::fill(newMap, newMap + newCapacity, nullptr);
+            std::copy(used, used + usedBlocks, newMap + newFirst);
+            delete [] blockMap;
+            blockMap = newMap;
+            mapCapacity = newCapacity;
+        }
+        else{
+            // the ranges may overlap, so copy in the direction of the shift
+            if (newFirst < firstBlock)
+                std::copy(used, used + usedBlocks, blockMap + newFirst);
+            else
+                std::copy_backward(used, used + usedBlocks, blockMap + newFirst + usedBlocks);
+            std::fill(blockMap, blockMap + newFirst, nullptr);
+            std::fill(blockMap + newFirst + usedBlocks, blockMap + mapCapacity, nullptr);
+        }
+        dataStart = newFirst * BLOCK_SIZE + dataStart % BLOCK_SIZE;
+    }
+
+    // destroys every element and returns every block, leaving an empty map
+    void destroyAll()
+    {
+        for (size_t i = 0; i < theSize; i++){
+            slot(dataStart + i)->~DataType();
+        }
+        for (size_t b = 0; b < mapCapacity; b++){
+            ::operator delete(blockMap[b]);
+            blockMap[b] = nullptr;
+        }
+        ::operator delete(spareBlock);
+        spareBlock = nullptr;
+        theSize = 0;
+    }
+
+    // sets up an empty deque whose single block sits in the middle of the map
+    void init()
+    {
+        mapCapacity = INIT_MAP_CAPACITY;
+        blockMap = new DataType*[mapCapacity];
+        std::fill(blockMap, blockMap + mapCapacity, nullptr);
+        theSize = 0;
+        spareBlock = nullptr;
+        size_t mid = mapCapacity / 2;
+        blockMap[mid] = newBlock();
+        dataStart = mid * BLOCK_SIZE + BLOCK_SIZE / 2;
+    }
+
+  public:
+
+    // default constructor
+    MyDeque()
+    {
+        init();
+    }
+
+    // copy constructor
+    MyDeque(const MyDeque & rhs)
+    {
+        init();
+        for (size_t i = 0; i < rhs.size(); i++){
+            push_back(rhs[i]);
+        }
+    }
+
+    // move constructor
+    MyDeque(MyDeque && rhs) :
+        blockMap{rhs.blockMap},
+        mapCapacity{rhs.mapCapacity},
+        dataStart{rhs.dataStart},
+        theSize{rhs.theSize},
+        spareBlock{rhs.spareBlock}
+    {
+        rhs.init();
+    }
+
+    // destructor
+    ~MyDeque()
+    {
+        destroyAll();
+        delete [] blockMap;
+    }
+
+    // copy assignment
+    MyDeque & operator= (const MyDeque & rhs)
+    {
+        MyDeque copy(rhs);
+        std::swap(*this, copy);
+        return *this;
+    }
+
+    // move assignment
+    MyDeque & operator= (MyDeque && rhs)
+    {
+        std::swap(blockMap, rhs.blockMap);
+        std::swap(mapCapacity, rhs.mapCapacity);
+        std::swap(dataStart, rhs.dataStart);
+        std::swap(theSize, rhs.theSize);
+        std::swap(spareBlock, rhs.spareBlock);
+        return *this;
+    }
+
+    // construct a new element in place at the back
+    template <typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        size_t pos = dataStart + theSize;
+        if (pos % BLOCK_SIZE == 0 && (pos / BLOCK_SIZE == mapCapacity || blockMap[pos / BLOCK_SIZE] == nullptr)){
+            reserveMap(0, 1);
+            pos = dataStart + theSize;
+            if (blockMap[pos / BLOCK_SIZE] == nullptr)
+                blockMap[pos / BLOCK_SIZE] = newBlock();
+        }
+
+        new (slot(pos)) DataType(std::forward<Args>(args)...);
+        theSize++;
+    }
+
+    // construct a new element in place at the front
+    template <typename... Args>
+    void emplace_front(Args&&... args)
+    {
+        if (dataStart % BLOCK_SIZE == 0){
+            reserveMap(1, 0);
+            if (blockMap[dataStart / BLOCK_SIZE - 1] == nullptr)
+                blockMap[dataStart / BLOCK_SIZE - 1] = newBlock();
+        }
+
+        new (slot(dataStart - 1)) DataType(std::forward<Args>(args)...);
+        dataStart--;
+        theSize++;
+    }
+
+    // insert x at the back
+    void push_back(const DataType & x)
+    {
+        emplace_back(x);
+    }
+
+    void push_back(DataType && x)
+    {
+        emplace_back(std::move(x));
+    }
+
+    // insert x at the front
+    void push_front(const DataType & x)
+    {
+        emplace_front(x);
+    }
+
+    void push_front(DataType && x)
+    {
+        emplace_front(std::move(x));
+    }
+
+    // remove the last element; releases its block once the block is empty
+    void pop_back()
+    {
+        if (theSize == 0)
+            return;
+
+        size_t pos = dataStart + theSize - 1;
+        slot(pos)->~DataType();
+        theSize--;
+        if (theSize == 0){
+            // keep the last block and restart from its middle so both ends have room
+            dataStart = pos / BLOCK_SIZE * BLOCK_SIZE + BLOCK_SIZE / 2;
+        }
+        else if (pos % BLOCK_SIZE == 0){
+            freeBlock(blockMap[pos / BLOCK_SIZE]);
+            blockMap[pos / BLOCK_SIZE] = nullptr;
+        }
+    }
+
+    // remove the first element; releases its block once the block is empty
+    void pop_front()
+    {
+        if (theSize == 0)
+            return;
+
+        size_t pos = dataStart;
+        slot(pos)->~DataType();
+        dataStart++;
+        theSize--;
+        if (theSize == 0){
+            dataStart = pos / BLOCK_SIZE * BLOCK_SIZE + BLOCK_SIZE / 2;
+        }
+        else if (dataStart % BLOCK_SIZE == 0){
+            freeBlock(blockMap[pos / BLOCK_SIZE]);
+            blockMap[pos / BLOCK_SIZE] = nullptr;
+        }
+    }
+
+    // remove the last element and return it; the deque must not be empty
+    DataType pop_back_and_get()
+    {
+        DataType x(std::move(back()));
+        pop_back();
+        return x;
+    }
+
+    // remove the first element and return it; the deque must not be empty
+    DataType pop_front_and_get()
+    {
+        DataType x(std::move(front()));
+        pop_front();
+        return x;
+    }
+
+    // data access operator (without bound checking)
+    DataType & operator[] (size_t index)
+    {
+        return *slot(dataStart + index);
+    }
+
+    const DataType & operator[] (size_t index) const
+    {
+        return *slot(dataStart + index);
+    }
+
+    // access the first element
+    DataType & front()
+    {
+        return *slot(dataStart);
+    }
+
+    const DataType & front() const
+    {
+        return *slot(dataStart);
+    }
+
+    // access the last element
+    DataType & back()
+    {
+        return *slot(dataStart + theSize - 1);
+    }
+
+    const DataType & back() const
+    {
+        return *slot(dataStart + theSize - 1);
+    }
+
+    // removes all elements
+    void clear()
+    {
+        destroyAll();
+        delete [] blockMap;
+        init();
+    }
+
+    // check if the deque is empty; return TRUE is empty; FALSE otherwise
+    bool empty() const
+    {
+        return theSize == 0;
+    }
+
+    // access the size of the deque
+    size_t size() const
+    {
+        return theSize;
+    }
+};
+
+
+#endif // __MYDEQUE_H__
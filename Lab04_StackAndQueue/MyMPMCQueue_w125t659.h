@@ -0,0 +1,253 @@
+#ifndef __MYMPMCQUEUE_H__
+#define __MYMPMCQUEUE_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// a bounded multi-producer/multi-consumer ring queue (Vyukov's sequence-numbered cells)
+// any number of threads may enqueue and dequeue concurrently; enqueue/dequeue never block,
+// wait_dequeue/wait_dequeue_for sleep on a condition variable while the queue stays empty
+template <typename DataType>
+class MyMPMCQueue
+{
+  private:
+    static const size_t CACHE_LINE = 64;    // size of a cache line on the targeted machines
+
+    // a slot of the ring; its sequence number tells whose turn it is
+    //   sequence == pos      : empty, the producer claiming pos may fill it
+    //   sequence == pos + 1  : full, the consumer claiming pos may empty it
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(DataType), alignof(DataType)>::type storage;
+
+        DataType * data()
+        {
+            return reinterpret_cast<DataType*>(&storage);
+        }
+    };
+
+    // written once at construction; shared read-only by all threads
+    size_t theCapacity;                 // number of cells in the ring; always a power of two
+    Cell *cells;
+    char pad0[CACHE_LINE];
+
+    std::atomic<size_t> dataEnd;        // next position to be claimed by a producer
+    char pad1[CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+    std::atomic<size_t> dataStart;      // next position to be claimed by a consumer
+    char pad2[CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+    // only touched when a consumer has to sleep
+    std::atomic<size_t> sleepers;       // number of consumers inside wait_dequeue(_for)
+    std::mutex waitMutex;
+    std::condition_variable notEmpty;
+
+    // wakes up one sleeping consumer, if there is any
+    void notify()
+    {
+        // pairs with the fence in wait_dequeue(_for): either we see the sleeper or it sees our element
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) != 0){
+            std::lock_guard<std::mutex> lock(waitMutex);
+            notEmpty.notify_one();
+        }
+    }
+
+  public:
+
+    // creates a queue holding at least minCapacity elements; rounded up to a power of two
+    explicit MyMPMCQueue(size_t minCapacity = 1024) :
+        theCapacity{2},
+        dataEnd{0},
+        dataStart{0},
+        sleepers{0}
+    {
+        while (theCapacity < minCapacity){
+            theCapacity *= 2;
+        }
+        cells = new Cell[theCapacity];
+        for (size_t i = 0; i < theCapacity; i++){
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // the queue is shared between threads and cannot be copied or moved
+    MyMPMCQueue(const MyMPMCQueue & rhs) = delete;
+    MyMPMCQueue & operator= (const MyMPMCQueue & rhs) = delete;
+
+    // destructor; must not race with any other thread
+    ~MyMPMCQueue()
+    {
+        size_t end = dataEnd.load(std::memory_order_relaxed);
+        for (size_t pos = dataStart.load(std::memory_order_relaxed); pos != end; pos++){
+            Cell& cell = cells[pos & (theCapacity - 1)];
+            if (cell.sequence.load(std::memory_order_relaxed) == pos + 1)
+                cell.data()->~DataType();
+        }
+        delete [] cells;
+    }
+
+    // insert x into the queue; returns false if the queue is full
+    bool enqueue(const DataType & x)
+    {
+        return emplace(x);
+    }
+
+    // insert x into the queue; returns false if the queue is full
+    bool enqueue(DataType && x)
+    {
+        return emplace(std::move(x));
+    }
+
+    // construct an element in place at the back; returns false if the queue is full
+    template <typename... Args>
+    bool emplace(Args&&... args)
+    {
+        size_t pos = dataEnd.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;){
+            cell = &cells[pos & (theCapacity - 1)];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            long long diff = static_cast<long long>(seq) - static_cast<long long>(pos);
+            if (diff == 0){
+                // the cell is free for this lap; try to claim the position
+                if (dataEnd.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0){
+                // the cell still holds the element from the previous lap
+                return false;
+            }
+            else{
+                // another producer claimed pos first
+                pos = dataEnd.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (cell->data()) DataType(std::forward<Args>(args)...);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        notify();
+        return true;
+    }
+
+    // remove the first element and move it into x; returns false if the queue is empty
+    bool dequeue(DataType & x)
+    {
+        size_t pos = dataStart.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;){
+            cell = &cells[pos & (theCapacity - 1)];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            long long diff = static_cast<long long>(seq) - static_cast<long long>(pos + 1);
+            if (diff == 0){
+                if (dataStart.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0){
+                // nothing has been published at pos yet
+                return false;
+            }
+            else{
+                pos = dataStart.load(std::memory_order_relaxed);
+            }
+        }
+
+        x = std::move(*cell->data());
+        cell->data()->~DataType();
+        // hand the cell to the producer of the next lap
+        cell->sequence.store(pos + theCapacity, std::memory_order_release);
+        return true;
+    }
+
+    // insert up to n elements from items; stops at the first full cell
+    // returns the number of elements actually inserted
+    size_t enqueue_bulk(const DataType * items, size_t n)
+    {
+        size_t i = 0;
+        while (i < n && enqueue(items[i])){
+            i++;
+        }
+        return i;
+    }
+
+    // remove up to n elements into out; stops as soon as the queue looks empty
+    // returns the number of elements actually removed
+    size_t dequeue_bulk(DataType * out, size_t n)
+    {
+        size_t i = 0;
+        while (i < n && dequeue(out[i])){
+            i++;
+        }
+        return i;
+    }
+
+    // remove the first element into x, sleeping until one is available or the timeout expires
+    // returns false on timeout
+    template <typename Rep, typename Period>
+    bool wait_dequeue_for(DataType & x, const std::chrono::duration<Rep, Period> & timeout)
+    {
+        if (dequeue(x))
+            return true;
+
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(waitMutex);
+        sleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool got = dequeue(x);
+        while (!got && notEmpty.wait_until(lock, deadline) != std::cv_status::timeout){
+            got = dequeue(x);
+        }
+        if (!got)
+            got = dequeue(x);
+
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+        return got;
+    }
+
+    // remove the first element into x, sleeping for as long as the queue is empty
+    void wait_dequeue(DataType & x)
+    {
+        if (dequeue(x))
+            return;
+
+        std::unique_lock<std::mutex> lock(waitMutex);
+        sleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        while (!dequeue(x)){
+            notEmpty.wait(lock);
+        }
+
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // check if the queue is empty; only a snapshot while other threads are running
+    bool empty(void) const
+    {
+        return size() == 0;
+    }
+
+    // access the size of the queue; only a snapshot while other threads are running
+    size_t size() const
+    {
+        size_t start = dataStart.load(std::memory_order_acquire);
+        size_t end = dataEnd.load(std::memory_order_acquire);
+        return end > start ? end - start : 0;
+    }
+
+    // access the capacity of the queue
+    size_t capacity(void) const
+    {
+        return theCapacity;
+    }
+};
+
+
+#endif // __MYMPMCQUEUE_H__
@@ -0,0 +1,181 @@
+#ifndef __MYSPSCQUEUE_H__
+#define __MYSPSCQUEUE_H__
+
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <utility>
+
+// a bounded single-producer/single-consumer ring queue
+// exactly one thread may call the enqueue functions and exactly one (other) thread the dequeue functions
+template <typename DataType>
+class MySPSCQueue
+{
+  private:
+    static const size_t CACHE_LINE = 64;    // size of a cache line on the targeted machines
+
+    // written once at construction; shared read-only by both threads
+    size_t theCapacity;                 // number of slots in the ring; always a power of two
+    DataType *queueData;                // raw circular storage
+    char pad0[CACHE_LINE];
+
+    // owned by the consumer
+    std::atomic<size_t> dataStart;      // running position of the first element
+    size_t cachedEnd;                   // the consumer's last view of dataEnd; saves reloading the producer's line
+    char pad1[CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+    // owned by the producer
+    std::atomic<size_t> dataEnd;        // running position one past the last element
+    size_t cachedStart;                 // the producer's last view of dataStart
+    char pad2[CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+    // maps a running position onto a slot of the ring
+    size_t slot(size_t pos) const
+    {
+        return pos & (theCapacity - 1);
+    }
+
+    // returns the number of free slots seen by the producer, refreshing its view of dataStart only if needed
+    size_t freeSlots(size_t end, size_t wanted)
+    {
+        size_t free = theCapacity - (end - cachedStart);
+        if (free < wanted){
+            cachedStart = dataStart.load(std::memory_order_acquire);
+            free = theCapacity - (end - cachedStart);
+        }
+        return free;
+    }
+
+    // returns the number of elements seen by the consumer, refreshing its view of dataEnd only if needed
+    size_t usedSlots(size_t start, size_t wanted)
+    {
+        size_t used = cachedEnd - start;
+        if (used < wanted){
+            cachedEnd = dataEnd.load(std::memory_order_acquire);
+            used = cachedEnd - start;
+        }
+        return used;
+    }
+
+  public:
+
+    // creates a queue holding at least minCapacity elements; rounded up to a power of two
+    explicit MySPSCQueue(size_t minCapacity = 1024) :
+        theCapacity{2},
+        dataStart{0},
+        cachedEnd{0},
+        dataEnd{0},
+        cachedStart{0}
+    {
+        while (theCapacity < minCapacity){
+            theCapacity *= 2;
+        }
+        queueData = static_cast<DataType*>(::operator new(theCapacity * sizeof(DataType)));
+    }
+
+    // the queue is shared by two threads and cannot be copied or moved
+    MySPSCQueue(const MySPSCQueue & rhs) = delete;
+    MySPSCQueue & operator= (const MySPSCQueue & rhs) = delete;
+
+    // destructor; must not race with either thread
+    ~MySPSCQueue()
+    {
+        size_t end = dataEnd.load(std::memory_order_relaxed);
+        for (size_t i = dataStart.load(std::memory_order_relaxed); i != end; i++){
+            queueData[slot(i)].~DataType();
+        }
+        ::operator delete(queueData);
+    }
+
+    // producer: insert x into the queue; returns false if the queue is full
+    bool enqueue(const DataType & x)
+    {
+        return emplace(x);
+    }
+
+    // producer: insert x into the queue; returns false if the queue is full
+    bool enqueue(DataType && x)
+    {
+        return emplace(std::move(x));
+    }
+
+    // producer: construct an element in place at the back; returns false if the queue is full
+    template <typename... Args>
+    bool emplace(Args&&... args)
+    {
+        size_t end = dataEnd.load(std::memory_order_relaxed);
+        if (freeSlots(end, 1) == 0)
+            return false;
+
+        new (&queueData[slot(end)]) DataType(std::forward<Args>(args)...);
+        dataEnd.store(end + 1, std::memory_order_release);
+        return true;
+    }
+
+    // producer: copy up to n elements from items into the queue with a single publication
+    // returns the number of elements actually inserted
+    size_t enqueue_bulk(const DataType * items, size_t n)
+    {
+        size_t end = dataEnd.load(std::memory_order_relaxed);
+        n = std::min(n, freeSlots(end, n));
+
+        for (size_t i = 0; i < n; i++){
+            new (&queueData[slot(end + i)]) DataType(items[i]);
+        }
+        dataEnd.store(end + n, std::memory_order_release);
+        return n;
+    }
+
+    // consumer: move the first element into x and remove it; returns false if the queue is empty
+    bool dequeue(DataType & x)
+    {
+        size_t start = dataStart.load(std::memory_order_relaxed);
+        if (usedSlots(start, 1) == 0)
+            return false;
+
+        DataType& item = queueData[slot(start)];
+        x = std::move(item);
+        item.~DataType();
+        dataStart.store(start + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer: move up to n elements into out and release their slots with a single publication
+    // returns the number of elements actually removed
+    size_t dequeue_bulk(DataType * out, size_t n)
+    {
+        size_t start = dataStart.load(std::memory_order_relaxed);
+        n = std::min(n, usedSlots(start, n));
+
+        for (size_t i = 0; i < n; i++){
+            DataType& item = queueData[slot(start + i)];
+            out[i] = std::move(item);
+            item.~DataType();
+        }
+        dataStart.store(start + n, std::memory_order_release);
+        return n;
+    }
+
+    // check if the queue is empty; only a snapshot while the other thread is running
+    bool empty(void) const
+    {
+        return size() == 0;
+    }
+
+    // access the size of the queue; only a snapshot while the other thread is running
+    size_t size() const
+    {
+        // read the start first so that the later end can never be behind it
+        size_t start = dataStart.load(std::memory_order_acquire);
+        return dataEnd.load(std::memory_order_acquire) - start;
+    }
+
+    // access the capacity of the queue
+    size_t capacity(void) const
+    {
+        return theCapacity;
+    }
+};
+
+
+#endif // __MYSPSCQUEUE_H__
@@ -3,97 +3,177 @@
 
 #include <iostream>
 #include <algorithm>
-
-#include "MyVector_w125t659.h"
+#include <new>
+#include <utility>
 
 template <typename DataType>
-class MyStack : private MyVector<DataType>
-{  
+class MyStack
+{
   private:
-    MyVector<DataType> stackData;
+    size_t theSize;         // the number of data elements the stack is currently holding
+    size_t theCapacity;     // maximum data elements the stack can hold before growing
+    DataType *stackData;    // raw storage; only the first theSize slots hold constructed elements
+
+    // allocates uninitialized storage for n data elements
+    static DataType * allocate(size_t n)
+    {
+        return static_cast<DataType*>(::operator new(n * sizeof(DataType)));
+    }
+
+    // destroys all elements and returns the storage
+    void release()
+    {
+        for (size_t i = 0; i < theSize; i++){
+            stackData[i].~DataType();
+        }
+        ::operator delete(stackData);
+    }
+
+    // grows the storage to newCapacity, moving (not copying) the elements over
+    void reserve(size_t newCapacity)
+    {
+        if (newCapacity <= theCapacity)
+            return;
+
+        DataType *newData = allocate(newCapacity);
+        for (size_t i = 0; i < theSize; i++){
+            new (&newData[i]) DataType(std::move(stackData[i]));
+            stackData[i].~DataType();
+        }
+        ::operator delete(stackData);
+
+        stackData = newData;
+        theCapacity = newCapacity;
+    }
 
   public:
 
+    static const size_t SPARE_CAPACITY = 16;   // initial capacity of the stack, same as MyVector
+
     // default constructor
-    explicit MyStack(size_t initSize = 0)
+    explicit MyStack(size_t initSize = 0) :
+        theSize{0},
+        theCapacity{initSize + SPARE_CAPACITY},
+        stackData{allocate(initSize + SPARE_CAPACITY)}
     {
-        stackData.reserve(initSize);    
+        ;
     }
 
     // copy constructor
-    MyStack(const MyStack & rhs)
+    MyStack(const MyStack & rhs) :
+        theSize{0},
+        theCapacity{rhs.theCapacity},
+        stackData{allocate(rhs.theCapacity)}
     {
-        stackData = rhs.stackData;
+        for (; theSize < rhs.theSize; theSize++){
+            new (&stackData[theSize]) DataType(rhs.stackData[theSize]);
+        }
     }
 
     // move constructor
-    MyStack(MyStack && rhs)
+    MyStack(MyStack && rhs) :
+        theSize{rhs.theSize},
+        theCapacity{rhs.theCapacity},
+        stackData{rhs.stackData}
     {
-        stackData = std::move(rhs.stackData);
+        rhs.theSize = 0;
+        rhs.theCapacity = 0;
+        rhs.stackData = nullptr;
     }
 
     // destructor
     ~MyStack()
     {
-        ;
+        release();
     }
 
     // copy assignment
     MyStack & operator= (const MyStack & rhs)
     {
-        stackData = rhs.stackData;
+        MyStack copy(rhs);
+        std::swap(*this, copy);
         return *this;
     }
 
     // move assignment
     MyStack & operator= (MyStack && rhs)
     {
-        stackData = std::move(rhs.stackData);
+        std::swap(theSize, rhs.theSize);
+        std::swap(theCapacity, rhs.theCapacity);
+        std::swap(stackData, rhs.stackData);
         return *this;
     }
 
     // insert x to the stack
     void push(const DataType & x)
     {
-        stackData.push_back(x);
+        emplace(x);
     }
 
     // insert x to the stack
     void push(DataType && x)
     {
-        stackData.push_back(x);
+        emplace(std::move(x));
+    }
+
+    // construct a new element in place on top of the stack
+    template <typename... Args>
+    void emplace(Args&&... args)
+    {
+        if (theSize == theCapacity){
+            reserve(2 * theCapacity + 1);
+        }
+
+        new (&stackData[theSize]) DataType(std::forward<Args>(args)...);
+        theSize++;
     }
 
     // remove the last element from the stack
     void pop(void)
     {
-        stackData.pop_back();
+        if (theSize > 0){
+            stackData[--theSize].~DataType();
+        }
+    }
+
+    // remove the last element from the stack and return it; the stack must not be empty
+    DataType pop_and_get(void)
+    {
+        DataType x(std::move(stackData[theSize - 1]));
+        pop();
+        return x;
+    }
+
+    // access the last element of the stack
+    DataType & top(void)
+    {
+        return stackData[theSize - 1];
     }
 
     // access the last element of the stack
     const DataType & top(void) const
     {
-        return stackData.back();
+        return stackData[theSize - 1];
     }
 
     // check if the stack is empty; return TRUE is empty; FALSE otherwise
     bool empty(void) const
     {
-        return stackData.empty();
+        return theSize == 0;
     }
 
     // access the size of the stack
     size_t size() const
     {
-        return stackData.size();
+        return theSize;
     }
 
     // access the capacity of the stack
-    size_t capacity(void) const 
+    size_t capacity(void) const
     {
-        return stackData.capacity();
+        return theCapacity;
     }
 };
 
 
-#endif // __MYSTACK_H__
\ No newline at end of file
+#endif // __MYSTACK_H__
@@ -0,0 +1,320 @@
+#ifndef __MYTHREADPOOL_H__
+#define __MYTHREADPOOL_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MyQueue_w125t659.h"
+#include "MyWorkStealingDeque_w125t659.h"
+
+// a fixed-size pool of worker threads with one work-stealing deque per worker
+// a worker runs its own newest task first (LIFO, like MyStack) and, once it runs dry,
+// steals the oldest task of another worker (FIFO, like MyQueue); tasks submitted from
+// outside the pool go through a shared MyQueue
+class MyThreadPool
+{
+  private:
+    typedef std::function<void()> Task;
+
+    // identifies the pool and deque owned by the calling thread, if it is a worker
+    struct WorkerInfo
+    {
+        MyThreadPool *pool;
+        size_t index;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<MyWorkStealingDeque<Task*>*> deques;    // deques[i] is owned by workers[i]
+
+    std::mutex injectMutex;
+    MyQueue<Task*> injected;            // tasks submitted by threads outside the pool
+    std::atomic<size_t> injectedSize;   // lets idle workers skip the mutex while the queue is empty
+
+    std::atomic<size_t> pending;        // submitted tasks that have not finished yet
+    std::atomic<bool> stopping;
+
+    // idle workers and wait() sleep here
+    std::atomic<size_t> sleepers;
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+
+    static WorkerInfo & self()
+    {
+        static thread_local WorkerInfo info = {nullptr, 0};
+        return info;
+    }
+
+    // wakes up one idle worker, if there is any
+    void notify()
+    {
+        // pairs with the fence in workerLoop(): either we see the sleeper or it sees the new task
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) != 0){
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            workAvailable.notify_one();
+        }
+    }
+
+    // looks for a task: own deque first, then the injected queue, then the other workers' deques
+    Task * findTask(size_t me, unsigned & seed)
+    {
+        Task *task = nullptr;
+        if (me < deques.size() && deques[me]->pop(task))
+            return task;
+
+        if (injectedSize.load(std::memory_order_acquire) != 0){
+            std::lock_guard<std::mutex> lock(injectMutex);
+            if (!injected.empty()){
+                task = injected.front();
+                injected.dequeue();
+                injectedSize.store(injected.size(), std::memory_order_release);
+                return task;
+            }
+        }
+
+        // start at a random victim so that thieves spread out
+        seed = seed * 1103515245u + 12345u;
+        size_t n = deques.size();
+        size_t start = (seed >> 8) % n;
+        for (size_t i = 0; i < n; i++){
+            size_t victim = (start + i) % n;
+            if (victim != me && deques[victim]->steal(task))
+                return task;
+        }
+        return nullptr;
+    }
+
+    // runs a task and retires it
+    void run(Task *task)
+    {
+        (*task)();
+        delete task;
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            allDone.notify_all();
+        }
+    }
+
+    // checks if any queue seems to hold a task
+    bool hasWork() const
+    {
+        if (injectedSize.load(std::memory_order_acquire) != 0)
+            return true;
+        for (auto d : deques){
+            if (!d->empty())
+                return true;
+        }
+        return false;
+    }
+
+    void workerLoop(size_t me)
+    {
+        self().pool = this;
+        self().index = me;
+        unsigned seed = static_cast<unsigned>(me) * 2654435761u + 1;
+
+        while (true){
+            Task *task = findTask(me, seed);
+            if (task != nullptr){
+                run(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!hasWork() && !stopping.load(std::memory_order_relaxed)){
+                // the timeout only guards against a thief losing a race with an owner's last pop
+                workAvailable.wait_for(lock, std::chrono::milliseconds(10));
+            }
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+
+            if (stopping.load(std::memory_order_relaxed) && pending.load(std::memory_order_acquire) == 0)
+                return;
+        }
+    }
+
+    // splits [begin, end) in halves until a piece is at most grain long
+    template <typename Func>
+    void forkRange(std::atomic<size_t> & outstanding, size_t begin, size_t end, size_t grain, const Func & f)
+    {
+        while (end - begin > grain){
+            size_t mid = begin + (end - begin) / 2;
+            outstanding.fetch_add(1, std::memory_order_relaxed);
+            submit([this, &outstanding, mid, end, grain, &f]{
+                forkRange(outstanding, mid, end, grain, f);
+                outstanding.fetch_sub(1, std::memory_order_release);
+            });
+            end = mid;
+        }
+        for (size_t i = begin; i < end; i++){
+            f(i);
+        }
+    }
+
+  public:
+
+    // starts the given number of worker threads (at least one)
+    explicit MyThreadPool(size_t threads = std::thread::hardware_concurrency()) :
+        injectedSize{0},
+        pending{0},
+        stopping{false},
+        sleepers{0}
+    {
+        if (threads == 0)
+            threads = 1;
+
+        for (size_t i = 0; i < threads; i++){
+            deques.push_back(new MyWorkStealingDeque<Task*>());
+        }
+        for (size_t i = 0; i < threads; i++){
+            workers.emplace_back(&MyThreadPool::workerLoop, this, i);
+        }
+    }
+
+    // the pool owns threads and cannot be copied or moved
+    MyThreadPool(const MyThreadPool & rhs) = delete;
+    MyThreadPool & operator= (const MyThreadPool & rhs) = delete;
+
+    // finishes every submitted task, then stops the workers
+    ~MyThreadPool()
+    {
+        wait();
+        stopping.store(true);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            workAvailable.notify_all();
+        }
+        for (auto& t : workers){
+            t.join();
+        }
+        for (auto d : deques){
+            delete d;
+        }
+    }
+
+    // schedules f to run on one of the workers
+    // a worker submitting a task pushes it on its own deque; other threads use the shared queue
+    template <typename Func>
+    void submit(Func && f)
+    {
+        Task *task = new Task(std::forward<Func>(f));
+        pending.fetch_add(1, std::memory_order_relaxed);
+
+        WorkerInfo& me = self();
+        if (me.pool == this){
+            deques[me.index]->push(task);
+        }
+        else{
+            std::lock_guard<std::mutex> lock(injectMutex);
+            injected.enqueue(task);
+            injectedSize.store(injected.size(), std::memory_order_release);
+        }
+        notify();
+    }
+
+    // runs one pending task on the calling thread, if one can be found; returns false otherwise
+    // lets a thread that waits for other tasks help instead of blocking
+    bool runPendingTask()
+    {
+        WorkerInfo& me = self();
+        size_t index = me.pool == this ? me.index : deques.size();
+        unsigned seed = static_cast<unsigned>(reinterpret_cast<size_t>(&me));
+        Task *task = findTask(index, seed);
+        if (task == nullptr)
+            return false;
+        run(task);
+        return true;
+    }
+
+    // calls f(i) for every i in [begin, end), in parallel, and returns once all calls are done
+    // the range is split recursively down to pieces of grain indices; the caller helps run them
+    template <typename Func>
+    void parallel_for(size_t begin, size_t end, const Func & f, size_t grain = 1)
+    {
+        if (begin >= end)
+            return;
+        if (grain == 0)
+            grain = 1;
+
+        std::atomic<size_t> outstanding(0);
+        forkRange(outstanding, begin, end, grain, f);
+        while (outstanding.load(std::memory_order_acquire) != 0){
+            if (!runPendingTask())
+                std::this_thread::yield();
+        }
+    }
+
+    // blocks until every submitted task has finished
+    // must not be called from inside a task; use MyTaskGroup to wait for nested tasks
+    void wait()
+    {
+        if (pending.load(std::memory_order_acquire) == 0)
+            return;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        while (pending.load(std::memory_order_acquire) != 0){
+            allDone.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    // access the number of worker threads
+    size_t size() const
+    {
+        return workers.size();
+    }
+};
+
+// a set of tasks that can be waited for from anywhere, including from inside another task
+// waiting runs pending tasks of the pool instead of blocking, which makes recursive fork-join safe
+class MyTaskGroup
+{
+  private:
+    MyThreadPool & pool;
+    std::atomic<size_t> outstanding;
+
+  public:
+
+    explicit MyTaskGroup(MyThreadPool & p) :
+        pool(p),
+        outstanding{0}
+    {
+        ;
+    }
+
+    // waits for the remaining tasks, as they may still refer to the group
+    ~MyTaskGroup()
+    {
+        wait();
+    }
+
+    // schedules f as part of the group
+    template <typename Func>
+    void run(Func f)
+    {
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        pool.submit([this, f]{
+            f();
+            outstanding.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    // returns once every task of the group has finished
+    void wait()
+    {
+        while (outstanding.load(std::memory_order_acquire) != 0){
+            if (!pool.runPendingTask())
+                std::this_thread::yield();
+        }
+    }
+};
+
+
+#endif // __MYTHREADPOOL_H__
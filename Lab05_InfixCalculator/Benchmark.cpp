@@ -0,0 +1,970 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+#include "MyInfixCalculator_w125t659.h"
+#include "MyBatchCalculator_w125t659.h"
+#include "MyBigDecimal_w125t659.h"
+#include "MyFixedPoint_w125t659.h"
+#include "MyFormulaGraph_w125t659.h"
+
+using namespace std;
+
+// every heap allocation made by the program is counted here
+static atomic<size_t> allocations(0);
+
+// every replaced operator new and delete below goes through these two
+// they are kept out of line so that the compiler does not see free() called on memory from operator new,
+// which -Wall reports as a mismatched deallocation
+__attribute__((noinline)) void * countedAllocate(size_t n)
+{
+    ++ allocations;
+    void *p = malloc(n == 0 ? 1 : n);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void countedFree(void *p) noexcept
+{
+    free(p);
+}
+
+void * operator new(size_t n)
+{
+    return countedAllocate(n);
+}
+
+void * operator new[](size_t n)
+{
+    return countedAllocate(n);
+}
+
+void operator delete(void *p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+// runs f once and returns the elapsed time in milliseconds
+template <typename Func>
+double timeIt(Func f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    auto stop = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(stop - start).count();
+}
+
+// prints the time and throughput of one benchmark run
+void report(const string& name, size_t evals, double ms)
+{
+    cout << "  " << name << ":\t" << ms << " ms\t" << evals / ms / 1000.0 << " M evals/s" << endl;
+}
+
+// the first line of every test input is one formula
+vector<string> loadFormulas()
+{
+    vector<string> formulas;
+    for (int id = 0; id < 10; ++ id)
+    {
+        ifstream f("./Inputs/input_" + to_string(id) + ".txt");
+        string line;
+        if (getline(f, line))
+            formulas.push_back(line);
+    }
+    return formulas;
+}
+
+// peak resident memory of the process so far, in MB
+double peakMemoryMB()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+// writes a random but well-formed expression of about `bytes` characters, a chunk at a time
+// parentheses nest at most 8 deep and every number is non-zero, so the value stays finite
+class ExpressionGenerator
+{
+  private:
+    size_t remaining;
+    unsigned seed;
+    int depth;
+    bool done;
+
+    unsigned next()
+    {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    }
+
+  public:
+    explicit ExpressionGenerator(size_t bytes, unsigned s = 12345) :
+        remaining{bytes},
+        seed{s},
+        depth{0},
+        done{false}
+    {
+        ;
+    }
+
+    // appends the next part of the expression to out; returns false once the expression is complete
+    bool generate(string& out)
+    {
+        if (done)
+            return false;
+
+        size_t start = out.size();
+        while (out.size() - start < 4096)
+        {
+            while (depth < 8 && next() % 4 == 0)
+            {
+                out += '(';
+                ++ depth;
+            }
+            out += to_string(next() % 1000 + 1);
+            out += '.';
+            out += static_cast<char>('0' + next() % 10);
+            while (depth > 0 && next() % 4 == 0)
+            {
+                out += ')';
+                -- depth;
+            }
+
+            if (out.size() - start >= remaining)
+            {
+                out.append(depth, ')');
+                done = true;
+                break;
+            }
+            out += "+-*/"[next() % 4];
+        }
+        remaining -= min(remaining, out.size() - start);
+        return true;
+    }
+};
+
+// an input stream over a generated expression; only one chunk of it is ever in memory
+class GeneratedExpressionBuffer : public streambuf
+{
+  private:
+    ExpressionGenerator generator;
+    string chunk;
+
+  protected:
+    int_type underflow() override
+    {
+        chunk.clear();
+        if (!generator.generate(chunk))
+            return traits_type::eof();
+        setg(&chunk[0], &chunk[0], &chunk[0] + chunk.size());
+        return traits_type::to_int_type(chunk[0]);
+    }
+
+  public:
+    explicit GeneratedExpressionBuffer(size_t bytes) :
+        generator(bytes)
+    {
+        ;
+    }
+};
+
+// checks that calculateStream() reads a stream line by line, with either line ending, and that
+// "while (in)" stops after the last line; returns the number of lines calculated wrongly
+size_t checkStreamLines()
+{
+    const char* lines[] = {"1 + 2", "3 * (4 - 1)", "2 ^ 3 ^ 2", "-(5 / 2)", "sqrt(16) + 1"};
+    const size_t numLines = sizeof(lines) / sizeof(lines[0]);
+
+    MyInfixCalculator calc(0);
+    size_t mismatches = 0;
+    const char* endings[] = {"\n", "\r\n"};
+    for (const char* ending : endings)
+    {
+        // the last line has no line ending once, and one more time has one
+        for (int last = 0; last < 2; ++ last)
+        {
+            string text;
+            for (size_t i = 0; i < numLines; ++ i)
+                text += string(lines[i]) + (i + 1 < numLines || last == 1 ? ending : "");
+
+            istringstream in(text);
+            size_t calculated = 0;
+            while (in)
+            {
+                double value = calc.calculateStream(in);
+                if (in.fail())
+                    break;
+                if (calculated >= numLines || value != calc.calculate(lines[calculated]))
+                    ++ mismatches;
+                ++ calculated;
+            }
+            if (calculated != numLines || !in.eof())
+                ++ mismatches;
+        }
+    }
+
+    cout << "Streamed lines: " << 4 * numLines << " lines, " << mismatches << " mismatches" << endl;
+    return mismatches;
+}
+
+// one huge expression: streamed through calculateStream() against materialised and run by calculate()
+void benchStream(size_t bytes)
+{
+    cout << "One generated expression of " << bytes / 1000000.0 << " MB" << endl;
+
+    MyInfixCalculator calc(0);
+    double streamed = 0;
+    double before = peakMemoryMB();
+    double ms = timeIt([&]{
+        GeneratedExpressionBuffer buffer(bytes);
+        istream in(&buffer);
+        streamed = calc.calculateStream(in);
+    });
+    cout << "  streamed:\t\t" << ms << " ms\t" << bytes / ms / 1000.0 << " MB/s\tpeak memory +"
+         << peakMemoryMB() - before << " MB" << endl;
+
+    double compiled = 0;
+    before = peakMemoryMB();
+    ms = timeIt([&]{
+        string expression;
+        ExpressionGenerator generator(bytes);
+        while (generator.generate(expression))
+            ;
+        compiled = calc.calculate(expression);
+    });
+    cout << "  materialised:\t" << ms << " ms\t" << bytes / ms / 1000.0 << " MB/s\tpeak memory +"
+         << peakMemoryMB() - before << " MB" << endl;
+
+    if (streamed != compiled)
+        cout << "  results differ: " << streamed << " vs " << compiled << endl;
+}
+
+// time and heap allocations of compiling the formulas, with the calculator's scratch space already grown
+void benchCompile(const vector<string>& formulas, size_t compiles)
+{
+    cout << "Compiling " << formulas.size() << " formulas (" << compiles << " compilations)" << endl;
+
+    MyInfixCalculator calc(0);
+    calc.compile(formulas[0]);
+
+    size_t allocs = allocations;
+    size_t codeSize = 0;
+    double ms = timeIt([&]{
+        for (size_t i = 0; i < compiles; ++ i)
+            codeSize += calc.compile(formulas[i % formulas.size()]).code.size();
+    });
+    allocs = allocations - allocs;
+    report("compile		", compiles, ms);
+    cout << "  " << static_cast<double>(allocs) / compiles << " allocations per expression" << endl;
+
+    if (codeSize == 0) cout << codeSize << endl;
+}
+
+// the same formulas evaluated over and over, with and without the compiled expression cache
+void benchCache(const vector<string>& formulas, size_t evals)
+{
+    cout << "Repeated evaluation of " << formulas.size() << " formulas (" << evals << " evaluations)" << endl;
+
+    // parsing is slow enough that a tenth of the evaluations will do
+    double sum = 0;
+    MyInfixCalculator cold(0);
+    size_t coldEvals = std::max<size_t>(evals / 10, 1);
+    double ms = timeIt([&]{
+        for (size_t i = 0; i < coldEvals; ++ i)
+            sum += cold.calculate(formulas[i % formulas.size()]);
+    });
+    report("cold (parse every time)", coldEvals, ms);
+
+    MyInfixCalculator cached;
+    ms = timeIt([&]{
+        for (size_t i = 0; i < evals; ++ i)
+            sum += cached.calculate(formulas[i % formulas.size()]);
+    });
+    report("cached (LRU lookup)\t", evals, ms);
+
+    vector<CompiledExpression> programs;
+    for (const string& f : formulas)
+        programs.push_back(cached.compile(f));
+    ms = timeIt([&]{
+        for (size_t i = 0; i < evals; ++ i)
+            sum += cached.evaluate(programs[i % programs.size()]);
+    });
+    report("precompiled\t\t", evals, ms);
+
+    if (sum == 0.123) cout << sum << endl;
+}
+
+// one formula evaluated for many different inputs: reformatting the text for every input
+// against compiling once and binding the inputs to variable slots
+void benchBindings(size_t evals)
+{
+    const string formula = "x * 2 + y * (x - 3) / 4 - (y + 1.5) * x";
+    cout << "One formula over " << evals << " different inputs: " << formula << endl;
+
+    double sum = 0;
+    MyInfixCalculator calc(0);
+    size_t textEvals = std::max<size_t>(evals / 10, 1);
+    double ms = timeIt([&]{
+        for (size_t i = 0; i < textEvals; ++ i)
+        {
+            string x = to_string(i % 1000), y = to_string(i % 7 + 1);
+            string s = x + " * 2 + " + y + " * (" + x + " - 3) / 4 - (" + y + " + 1.5) * " + x;
+            sum += calc.calculate(s);
+        }
+    });
+    report("format and parse	", textEvals, ms);
+
+    CompiledExpression e = calc.compile(formula);
+    int xs = e.slot("x"), ys = e.slot("y");
+    double bindings[2];
+    ms = timeIt([&]{
+        for (size_t i = 0; i < evals; ++ i)
+        {
+            bindings[xs] = i % 1000;
+            bindings[ys] = i % 7 + 1;
+            sum += calc.evaluate(e, bindings);
+        }
+    });
+    report("compile once, bind	", evals, ms);
+
+    if (sum == 0.123) cout << sum << endl;
+}
+
+// one formula over columns of inputs: a per-row evaluate() call against evaluateBatch() over whole columns
+void benchBatch(size_t rows)
+{
+    const string formula = "x * 2 + y * (x - 3) / 4 - (y + 1.5) * x";
+    cout << "One formula over " << rows << " rows of columns: " << formula << endl;
+
+    MyInfixCalculator calc;
+    CompiledExpression e = calc.compile(formula);
+    vector<double> x(rows), y(rows), out(rows);
+    for (size_t i = 0; i < rows; ++ i)
+    {
+        x[i] = i % 1000;
+        y[i] = i % 7 + 1;
+    }
+    vector<const double*> columns(e.variables.size());
+    columns[e.slot("x")] = x.data();
+    columns[e.slot("y")] = y.data();
+
+    double ms = timeIt([&]{
+        double bindings[2];
+        for (size_t i = 0; i < rows; ++ i)
+        {
+            bindings[0] = columns[0][i];
+            bindings[1] = columns[1][i];
+            out[i] = calc.evaluate(e, bindings);
+        }
+    });
+    report("per row		", rows, ms);
+    double check = out[rows - 1];
+
+    ms = timeIt([&]{
+        calc.evaluateBatch(e, columns.data(), out.data(), rows);
+    });
+#ifdef __AVX2__
+    report("batched (AVX2)	", rows, ms);
+#else
+    report("batched (scalar)	", rows, ms);
+#endif
+
+    if (out[rows - 1] != check)
+        cout << "  batched result differs: " << out[rows - 1] << " vs " << check << endl;
+}
+
+// a random expression over x, y and z that often repeats one of its own subexpressions
+// and often multiplies by 1 or adds 0, so that every rewrite of the optimizer gets exercised
+string randomExpression(unsigned& seed, vector<string>& seen, int depth)
+{
+    seed = seed * 1103515245u + 12345u;
+    unsigned r = seed >> 8;
+
+    if (!seen.empty() && r % 5 == 0)
+        return seen[r / 5 % seen.size()];
+    if (depth == 0 || r % 7 == 0)
+    {
+        static const char* leaves[] = {"x", "y", "z", "-x", "0", "1", "2", "0.5", "3", "1.5"};
+        return leaves[r / 7 % 10];
+    }
+
+    static const char* operators[] = {"+", "-", "*", "/", "+", "-", "*", "/", "%", "^", "<", "==", "min", "max", "sqrt", "abs"};
+    string op = operators[r / 7 % 16];
+    string lhs = randomExpression(seed, seen, depth - 1);
+    string e;
+    if (op == "sqrt" || op == "abs")
+        e = op + "(" + lhs + ")";
+    else if (op == "min" || op == "max")
+        e = op + "(" + lhs + "," + randomExpression(seed, seen, depth - 1) + ")";
+    else
+        e = "(" + lhs + op + randomExpression(seed, seen, depth - 1) + ")";
+    seen.push_back(e);
+    return e;
+}
+
+// checks if two results are the same double, bit for bit, but for the payload of a NaN
+// anyZero also takes -0 and +0 as the same, which is all that rewriting x * 0 to 0 promises
+bool sameResult(double a, double b, bool anyZero = false)
+{
+    if (std::isnan(a) || std::isnan(b))
+        return std::isnan(a) && std::isnan(b);
+    if (anyZero && a == 0 && b == 0)
+        return true;
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// checks that optimized and unoptimized programs agree on random expressions and inputs,
+// and measures how many instructions the optimizer saves
+// returns the number of disagreements
+size_t checkOptimizer(size_t expressions)
+{
+    cout << "Optimized against unoptimized programs (" << expressions << " random expressions)" << endl;
+
+    // the first seven values cannot overflow in expressions of this size
+    static const double values[] = {0.0, -0.0, 1.0, -1.0, 2.0, 0.5, 3.0, 1e308, -1e-300, INFINITY, NAN};
+    const size_t numValues = sizeof(values) / sizeof(values[0]);
+    const size_t numFiniteValues = 7;
+
+    MyInfixCalculator calc(0);
+    unsigned seed = 2024;
+    size_t mismatches = 0, checks = 0, plainCode = 0, optimizedCode = 0, finiteCode = 0;
+
+    // the evaluator reports every division by zero, which random inputs hit all the time
+    stringbuf reported;
+    streambuf* errors = cerr.rdbuf(&reported);
+    for (size_t i = 0; i < expressions; ++ i)
+    {
+        vector<string> seen;
+        string s = randomExpression(seed, seen, 6);
+        CompiledExpression plain = calc.compile(s, false);
+        CompiledExpression optimized = calc.optimize(plain);
+        CompiledExpression finite = calc.optimize(plain, true);
+        plainCode += plain.code.size();
+        optimizedCode += optimized.code.size();
+        finiteCode += finite.code.size();
+
+        // x % 0, sqrt(-1) or 0 ^ -1 make NaN or infinity out of finite values without reporting anything,
+        // so the finite inputs only keep expressions of + - * / finite
+        bool arithmetic = true;
+        for (const Instruction& ins : plain.code)
+            arithmetic = arithmetic && ins.op != OpCode::CALL1 && ins.op != OpCode::CALL2;
+
+        double bindings[3];
+        vector<double> columns[3];
+        for (size_t j = 0; j < 64; ++ j)
+        {
+            // every other row sticks to values that keep the whole computation finite
+            for (size_t v = 0; v < plain.variables.size(); ++ v)
+            {
+                seed = seed * 1103515245u + 12345u;
+                bindings[v] = values[(seed >> 8) % (j % 2 == 0 ? numValues : numFiniteValues)];
+                columns[v].push_back(bindings[v]);
+            }
+
+            reported.str("");
+            double expected = calc.evaluate(plain, bindings);
+            bool divided = !reported.str().empty();
+
+            ++ checks;
+            if (!sameResult(expected, calc.evaluate(optimized, bindings)))
+            {
+                if (++ mismatches <= 5)
+                    cout << "  mismatch: " << s << endl;
+            }
+            // both interpreters run the same program, so they must agree bit for bit
+            double switched = calc.evaluate(plain, bindings, MyInfixCalculator::Dispatch::SWITCH);
+            if (memcmp(&expected, &switched, sizeof(double)) != 0 && !(std::isnan(expected) && std::isnan(switched)))
+            {
+                if (++ mismatches <= 5)
+                    cout << "  mismatch between interpreters: " << s << endl;
+            }
+            // dropping x * 0 may drop a division by zero inside x, which assumeFinite rules out
+            if (j % 2 == 1 && arithmetic && !divided && !sameResult(expected, calc.evaluate(finite, bindings), true))
+            {
+                if (++ mismatches <= 5)
+                    cout << "  mismatch assuming finite inputs: " << s << endl;
+            }
+        }
+
+        // the batched evaluator runs the temporaries too
+        const double* columnData[3] = {columns[0].data(), columns[1].data(), columns[2].data()};
+        vector<double> plainOut(64), optimizedOut(64);
+        calc.evaluateBatch(plain, columnData, plainOut.data(), 64);
+        calc.evaluateBatch(optimized, columnData, optimizedOut.data(), 64);
+        for (size_t j = 0; j < 64; ++ j)
+        {
+            if (!sameResult(plainOut[j], optimizedOut[j]) && ++ mismatches <= 5)
+                cout << "  batched mismatch: " << s << endl;
+        }
+    }
+    cerr.rdbuf(errors);
+
+    cout << "  " << checks << " evaluations, " << mismatches << " mismatches" << endl;
+    cout << "  instructions per expression: " << static_cast<double>(plainCode) / expressions << " unoptimized, "
+         << static_cast<double>(optimizedCode) / expressions << " optimized, "
+         << static_cast<double>(finiteCode) / expressions << " assuming finite inputs" << endl;
+    return mismatches;
+}
+
+// a formula with constant parts, identities and a repeated subexpression, with and without the optimizer
+void benchOptimizer(size_t evals)
+{
+    const string formula = "(x*y+1)*(x*y+1) + (x*y+1)/2*1 + (2*3-4)*x + y*1 - 0 + (x*y+1)";
+    cout << "One formula over " << evals << " different inputs: " << formula << endl;
+
+    MyInfixCalculator calc;
+    CompiledExpression plain = calc.compile(formula, false);
+    CompiledExpression optimized = calc.compile(formula);
+
+    double sum = 0;
+    double bindings[2];
+    for (const CompiledExpression* e : {&plain, &optimized})
+    {
+        double ms = timeIt([&]{
+            for (size_t i = 0; i < evals; ++ i)
+            {
+                bindings[0] = i % 1000;
+                bindings[1] = i % 7 + 1;
+                sum += calc.evaluate(*e, bindings);
+            }
+        });
+        report(e == &plain ? "unoptimized (" + to_string(e->code.size()) + " instructions)"
+                           : "optimized (" + to_string(e->code.size()) + " instructions)", evals, ms);
+    }
+
+    if (sum == 0.123) cout << sum << endl;
+}
+
+// the cost of running operators through their operatorTable() kernels rather than dedicated opcodes,
+// and the throughput of the operators that only exist as kernels
+void benchOperators(size_t evals)
+{
+    const string arithmetic = "x * 2 + y * (x - 3) / 4 - (y + 1.5) * x";
+    const string extended = "max(x, y) ^ 2 % 7 + sqrt(abs(x - y)) * (x >= y)";
+    cout << "Operator dispatch over " << evals << " different inputs" << endl;
+
+    MyInfixCalculator calc;
+    CompiledExpression dedicated = calc.compile(arithmetic);
+
+    // the same program with every operator called through the table, as a new operator would be
+    CompiledExpression kernels = dedicated;
+    for (Instruction& ins : kernels.code)
+    {
+        if (ins.op == OpCode::NEG)
+            ins.op = OpCode::CALL1;
+        else if (ins.op == OpCode::ADD || ins.op == OpCode::SUB || ins.op == OpCode::MUL || ins.op == OpCode::DIV)
+            ins.op = OpCode::CALL2;
+    }
+    CompiledExpression others = calc.compile(extended);
+
+    double sum = 0;
+    double bindings[2];
+    auto run = [&](const string& name, const CompiledExpression& e){
+        double ms = timeIt([&]{
+            for (size_t i = 0; i < evals; ++ i)
+            {
+                bindings[0] = i % 1000;
+                bindings[1] = i % 7 + 1;
+                sum += calc.evaluate(e, bindings);
+            }
+        });
+        report(name, evals, ms);
+    };
+    run("arithmetic, opcodes\t", dedicated);
+    run("arithmetic, kernels\t", kernels);
+    run("^ % >= max sqrt abs\t", others);
+
+    if (sum == 0.123) cout << sum << endl;
+}
+
+// the cost of one instruction under each interpreter, on the test formulas and on one with variables
+void benchDispatch(const vector<string>& formulas, size_t evals)
+{
+    cout << "Interpreter dispatch (" << evals << " evaluations per formula)" << endl;
+
+    MyInfixCalculator calc;
+    vector<CompiledExpression> programs;
+    // unoptimized, as the optimizer folds the test formulas down to one constant each
+    for (const string& f : formulas)
+        programs.push_back(calc.compile(f, false));
+    programs.push_back(calc.compile("x * 2 + y * (x - 3) / 4 - (y + 1.5) * x", false));
+
+    size_t instructions = 0;
+    for (const CompiledExpression& e : programs)
+        instructions += e.code.size();
+    cout << "  " << programs.size() << " formulas, " << instructions << " instructions" << endl;
+
+    static const MyInfixCalculator::Dispatch dispatches[] = {MyInfixCalculator::Dispatch::SWITCH, MyInfixCalculator::Dispatch::THREADED};
+    static const char* names[] = {"switch", "computed goto"};
+    double sums[2] = {0, 0};
+    for (int d = 0; d < 2; ++ d)
+    {
+        double bindings[2];
+        double ms = timeIt([&]{
+            for (size_t i = 0; i < evals; ++ i)
+            {
+                bindings[0] = i % 1000;
+                bindings[1] = i % 7 + 1;
+                for (const CompiledExpression& e : programs)
+                    sums[d] += calc.evaluate(e, bindings, dispatches[d]);
+            }
+        });
+        cout << "  " << names[d] << "\t:\t" << ms << " ms\t" << ms * 1e6 / (evals * instructions) << " ns/instruction" << endl;
+    }
+    if (sums[0] != sums[1])
+        cout << "  ERROR: the interpreters disagree" << endl;
+}
+
+// evaluates programs in one numeric type, with x and y bound to the same values as benchNumbers() uses for double
+// the numbers of each program are converted to Number once, before the timing starts
+template <typename Number>
+void benchNumber(const string& name, MyInfixCalculator& calc, const vector<CompiledExpression>& compiled, size_t evals, double check)
+{
+    vector<PreparedExpression<Number> > programs;
+    for (const CompiledExpression& e : compiled)
+        programs.push_back(calc.prepareAs<Number>(e));
+
+    vector<Number> xs(1000), ys(7);
+    for (size_t i = 0; i < xs.size(); ++ i)
+        NumberTraits<Number>::fromDouble(static_cast<double>(i), xs[i]);
+    for (size_t i = 0; i < ys.size(); ++ i)
+        NumberTraits<Number>::fromDouble(static_cast<double>(i + 1), ys[i]);
+
+    double sum = 0;
+    Number bindings[2];
+    double ms = timeIt([&]{
+        for (size_t i = 0; i < evals; ++ i)
+        {
+            bindings[0] = xs[i % 1000];
+            bindings[1] = ys[i % 7];
+            for (const PreparedExpression<Number>& p : programs)
+                sum += NumberTraits<Number>::toDouble(calc.evaluateAs<Number>(p, bindings));
+        }
+    });
+    report(name, evals * programs.size(), ms);
+    // the exact types round differently, so only a gross disagreement is an error
+    if (!(fabs(sum - check) <= 1e-6 * fabs(check) + 1e-6))
+        cout << "  ERROR: " << name << " sums to " << sum << " rather than about " << check << endl;
+}
+
+// the numeric backends on formulas that stay within the range of a 64-bit fixed-point number
+void benchNumbers(size_t evals)
+{
+    const vector<string> formulas = {
+        "x * 2 + y * (x - 3) / 4 - (y + 1.5) * x",
+        "(x * 1.0825 - 12.5) * (1 + y / 100) - x / 3",
+        "1234.5678 * 3 - 0.0001 * x + max(x, y) - abs(y - x)"
+    };
+    cout << "Numeric backends (" << evals << " evaluations of " << formulas.size() << " formulas)" << endl;
+
+    MyInfixCalculator calc;
+    vector<CompiledExpression> programs;
+    for (const string& f : formulas)
+        programs.push_back(calc.compile(f, false));
+
+    double sum = 0;
+    double bindings[2];
+    double ms = timeIt([&]{
+        for (size_t i = 0; i < evals; ++ i)
+        {
+            bindings[0] = i % 1000;
+            bindings[1] = i % 7 + 1;
+            for (const CompiledExpression& e : programs)
+                sum += calc.evaluate(e, bindings);
+        }
+    });
+    report("double, evaluate()\t", evals * programs.size(), ms);
+
+    benchNumber<double>("double, evaluateAs()", calc, programs, evals, sum);
+    benchNumber<MyFixedPoint<4> >("MyFixedPoint<4>\t", calc, programs, evals, sum);
+    benchNumber<MyBigDecimal>("MyBigDecimal\t", calc, programs, evals, sum);
+}
+
+// a file of many short independent expressions, evaluated line by line from one up to every core
+void benchBatchFile(size_t lines)
+{
+    const string path = "batch_bench.txt";
+    {
+        ofstream file(path);
+        string line;
+        for (size_t i = 0; i < lines; ++ i)
+        {
+            ExpressionGenerator generator(40 + i % 80, static_cast<unsigned>(i) + 1);
+            line.clear();
+            while (generator.generate(line))
+                ;
+            file << line << '\n';
+        }
+    }
+    cout << "Batch file of " << lines << " expressions" << endl;
+
+    // the plain loop MainTest would need without batch mode
+    string expected;
+    double ms = timeIt([&]{
+        MyInfixCalculator calc;
+        ifstream file(path);
+        string line;
+        char result[64];
+        while (getline(file, line))
+        {
+            int n = snprintf(result, sizeof(result), "%.3f\n", calc.calculate(line));
+            expected.append(result, n);
+        }
+    });
+    cout << "  getline loop\t\t:\t" << ms << " ms\t" << lines / ms / 1000.0 << " M lines/s" << endl;
+
+    size_t maxThreads = std::max<size_t>(thread::hardware_concurrency(), 2);
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        MyBatchCalculator batch(threads);
+        ostringstream out;
+        size_t evaluated = 0;
+        ms = timeIt([&]{ batch.calculateFile(path, out, &evaluated); });
+        cout << "  " << threads << " worker(s)\t\t:\t" << ms << " ms\t" << lines / ms / 1000.0 << " M lines/s" << endl;
+        if (evaluated != lines || out.str() != expected)
+            cout << "  ERROR: batch results differ from the getline loop" << endl;
+    }
+    remove(path.c_str());
+}
+
+// a stream buffer that throws away everything written to it
+class NullBuffer : public streambuf
+{
+  protected:
+    int_type overflow(int_type c) override
+    {
+        return c;
+    }
+};
+
+// a file of generated expressions, every tenth of them broken in one of four ways; reporting every error
+// through std::cerr as calculate() does, against counting CalcResults from tryCalculate()
+// a generated expression may also divide by a difference that comes out zero, so a few more lines fail
+void benchErrors(size_t lines)
+{
+    const string path = "errors_bench.txt";
+    const char* breakages[] = {"$", "/0", "*", "("};    // a skipped character, a division by zero, a missing operand, an open parenthesis
+    size_t broken = 0;
+    {
+        ofstream file(path);
+        string line;
+        for (size_t i = 0; i < lines; ++ i)
+        {
+            ExpressionGenerator generator(40 + i % 80, static_cast<unsigned>(i) + 1);
+            line.clear();
+            while (generator.generate(line))
+                ;
+            if (i % 10 == 0)
+            {
+                const string breakage = breakages[(i / 10) % 4];
+                if (breakage == "$")
+                    line.insert(line.size() / 2, breakage);
+                else if (breakage == "(")
+                    line.insert(0, breakage);
+                else
+                    line += breakage;
+                ++ broken;
+            }
+            file << line << '\n';
+        }
+    }
+    cout << "Batch file of " << lines << " expressions, " << broken << " of them malformed" << endl;
+
+    vector<string> text;
+    {
+        ifstream file(path);
+        string line;
+        while (getline(file, line))
+            text.push_back(line);
+    }
+
+    // cerr is unbuffered, so every message is a write to the device, as it would be to a terminal
+    ofstream devnull("/dev/null");
+    streambuf* console = cerr.rdbuf(devnull.rdbuf());
+    double ms = timeIt([&]{
+        MyInfixCalculator calc;
+        for (const string& line : text)
+            calc.calculate(line);
+    });
+    cerr.rdbuf(console);
+    cout << "  calculate(), errors to cerr\t:\t" << ms << " ms\t" << lines / ms / 1000.0 << " M lines/s" << endl;
+
+    size_t failed = 0;
+    ms = timeIt([&]{
+        MyInfixCalculator calc;
+        for (const string& line : text)
+            failed += calc.tryCalculate(line).ok() ? 0 : 1;
+    });
+    cout << "  tryCalculate(), counted\t:\t" << ms << " ms\t" << lines / ms / 1000.0 << " M lines/s" << endl;
+    cout << "  " << failed << " lines failed" << endl;
+    if (failed < broken)
+        cout << "  ERROR: " << failed << " failures counted, at least " << broken << " expected" << endl;
+
+    NullBuffer discard;
+    ostream nowhere(&discard);
+    size_t evaluated = 0;
+    size_t batchFailed = 0;
+    ostringstream reported;
+    MyBatchCalculator batch(1);
+    ms = timeIt([&]{ batch.calculateFile(path, nowhere, &evaluated, &batchFailed, &reported); });
+    cout << "  batch, 1 worker, reported\t:\t" << ms << " ms\t" << lines / ms / 1000.0 << " M lines/s" << endl;
+    const string messages = reported.str();
+    size_t reports = count(messages.begin(), messages.end(), '\n');
+    if (evaluated != lines || batchFailed != failed || reports != failed)
+        cout << "  ERROR: batch found " << batchFailed << " failures and reported " << reports << ", " << failed << " expected" << endl;
+
+    ms = timeIt([&]{ batch.calculateFile(path, nowhere, &evaluated, &batchFailed, nullptr); });
+    cout << "  batch, 1 worker, counted\t:\t" << ms << " ms\t" << lines / ms / 1000.0 << " M lines/s" << endl;
+    if (batchFailed != failed)
+        cout << "  ERROR: batch counted " << batchFailed << " failures, " << failed << " expected" << endl;
+    remove(path.c_str());
+}
+
+// a spreadsheet of about `cells` cells: per input v, the derived cells d = v * 1.07 + 3, e = d - v / 2 and
+// f = max(e, 0), and a tree of sums over every f, eight cells to a sum, up to one total
+// recalculating everything, as re-running every formula through calculate() would, against recalculating
+// only what depends on one changed input
+void benchFormulaGraph(size_t cells, size_t threads)
+{
+    size_t leaves = std::max<size_t>(cells / 4, 8);
+    MyFormulaGraph graph(threads);
+    vector<double> inputs(leaves);
+    unsigned seed = 12345;
+    auto next = [&seed]{
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+
+    string total;
+    double ms = timeIt([&]{
+        vector<string> level;
+        for (size_t i = 0; i < leaves; ++ i)
+        {
+            string n = to_string(i);
+            inputs[i] = static_cast<double>(next() % 2000) - 500.0;
+            graph.setValue("v" + n, inputs[i]);
+            graph.setFormula("d" + n, "v" + n + " * 1.07 + 3");
+            graph.setFormula("e" + n, "d" + n + " - v" + n + " / 2");
+            graph.setFormula("f" + n, "max(e" + n + ", 0)");
+            level.push_back("f" + n);
+        }
+        for (int depth = 1; level.size() > 1; ++ depth)
+        {
+            vector<string> sums;
+            for (size_t i = 0; i < level.size(); i += 8)
+            {
+                string formula = level[i];
+                for (size_t j = i + 1; j < i + 8 && j < level.size(); ++ j)
+                    formula += " + " + level[j];
+                sums.push_back("s" + to_string(depth) + "x" + to_string(i / 8));
+                graph.setFormula(sums.back(), formula);
+            }
+            level.swap(sums);
+        }
+        total = level[0];
+    });
+    cout << "Formula graph of " << graph.size() << " cells, " << threads << " worker thread(s)" << endl;
+    cout << "  build\t\t\t:\t" << ms << " ms\t" << peakMemoryMB() << " MB peak" << endl;
+
+    size_t recalculated = 0;
+    ms = timeIt([&]{ recalculated = graph.recalculate(); });
+    cout << "  recalculate all\t:\t" << ms << " ms\t" << recalculated << " cells" << endl;
+
+    // the same sums in C++, in the order the tree adds them
+    auto expected = [&]{
+        vector<double> level;
+        for (double v : inputs)
+            level.push_back(std::max((v * 1.07 + 3) - v / 2, 0.0));
+        while (level.size() > 1)
+        {
+            vector<double> sums;
+            for (size_t i = 0; i < level.size(); i += 8)
+            {
+                double sum = level[i];
+                for (size_t j = i + 1; j < i + 8 && j < level.size(); ++ j)
+                    sum += level[j];
+                sums.push_back(sum);
+            }
+            level.swap(sums);
+        }
+        return level[0];
+    };
+
+    const size_t changes = 1000;
+    recalculated = 0;
+    ms = timeIt([&]{
+        for (size_t i = 0; i < changes; ++ i)
+        {
+            size_t leaf = next() % leaves;
+            inputs[leaf] = static_cast<double>(next() % 2000) - 500.0;
+            graph.setValue("v" + to_string(leaf), inputs[leaf]);
+            recalculated += graph.recalculate();
+        }
+    });
+    cout << "  one input changed\t:\t" << ms * 1000.0 / changes << " us per change\t"
+         << static_cast<double>(recalculated) / changes << " cells recalculated" << endl;
+
+    double want = expected();
+    double got = graph.value(total);
+    if (!graph.result(total).ok() || std::fabs(got - want) > 1e-9 * std::fabs(want))
+        cout << "  ERROR: total is " << got << ", expected " << want << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t evals = argc > 1 ? stoull(argv[1]) : 1000000;
+
+    vector<string> formulas = loadFormulas();
+    if (formulas.empty())
+    {
+        cout << "Run the benchmark from the lab directory so that ./Inputs can be found." << endl;
+        return 1;
+    }
+
+    // first, while the peak memory of the process is still low
+    benchStream(evals * 100);
+    checkStreamLines();
+    benchCompile(formulas, std::max<size_t>(evals / 10, 1));
+    benchCache(formulas, evals);
+    benchBindings(evals);
+    benchBatch(evals * 10);
+    checkOptimizer(10000);
+    benchOptimizer(evals);
+    benchOperators(evals);
+    benchDispatch(formulas, evals / 10);
+    benchNumbers(evals / 10);
+    benchBatchFile(evals / 4);
+    benchErrors(evals);
+    benchFormulaGraph(evals, 0);
+    benchFormulaGraph(evals, std::max<size_t>(thread::hardware_concurrency(), 2));
+
+    return 0;
+}
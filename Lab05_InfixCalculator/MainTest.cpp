@@ -1,3 +1,5 @@
+#include <cerrno>
+#include <cstdlib>
 #include <iostream>
 #include <iomanip>
 #include <vector>
@@ -5,14 +7,52 @@
 #include <string>
 
 #include "MyInfixCalculator_w125t659.h"
+#include "MyBatchCalculator_w125t659.h"
 
 using namespace std;
 
+void printUsage()
+{
+    std::cout << "You have to provide one test instance file and output file name to run the test main!\n";
+    std::cout << "Or evaluate every line of a file with: --batch <file> [threads]\n";
+}
+
+// reads a thread count: decimal digits only, within the range of unsigned long
+bool parseThreads(const char* text, size_t& threads)
+{
+    if (*text < '0' || *text > '9')
+        return false;
+
+    char* end;
+    errno = 0;
+    unsigned long n = strtoul(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE)
+        return false;
+    threads = n;
+    return true;
+}
+
 int main(int argc, char* argv[])
 {
+    // batch mode: every line of the file is an expression, evaluated in parallel
+    // the results are printed one per line, in the order of the input
+    if ((argc == 3 || argc == 4) && string(argv[1]) == "--batch")
+    {
+        size_t threads = std::thread::hardware_concurrency();
+        if (argc == 4 && !parseThreads(argv[3], threads))
+        {
+            printUsage();
+            return 0;
+        }
+        MyBatchCalculator batch_calculator(threads);
+        if (!batch_calculator.calculateFile(argv[2], cout))
+            cout << "The instance.txt file cannot be opened";
+        return 0;
+    }
+
     if (argc != 2)
     {
-        std::cout << "You have to provide one test instance file and output file name to run the test main!\n";
+        printUsage();
         return 0;
     }
 
@@ -0,0 +1,173 @@
+#ifndef __MYBATCHCALCULATOR_H__
+#define __MYBATCHCALCULATOR_H__
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MyInfixCalculator_w125t659.h"
+#include "MyMappedFile_w125t659.h"
+#include "MyThreadPool_w125t659.h"
+
+// evaluates files of independent expressions, one per line, on all cores
+// the text is cut into chunks of whole lines that the workers of a thread pool evaluate in parallel,
+// each with a calculator of its own; results are written in the order of the lines all the same
+class MyBatchCalculator
+{
+  private:
+    // a line that could not be calculated
+    struct LineError
+    {
+        size_t line;        // counted from the first line of its chunk
+        size_t begin;       // where the line starts in the text
+        size_t length;
+        CalcResult result;
+    };
+
+    MyThreadPool pool;
+    std::vector<MyInfixCalculator*> calculators;    // calculators[i] is used by worker i only; the last one by the caller
+
+    // returns the start of the first line that begins at or after position of text
+    static size_t lineStart(const char* text, size_t length, size_t position)
+    {
+        if (position == 0)
+            return 0;
+        if (position >= length)
+            return length;
+
+        const void* newline = std::memchr(text + position - 1, '\n', length - position + 1);
+        return newline == nullptr ? length : static_cast<const char*>(newline) - text + 1;
+    }
+
+    // evaluates the lines of text[begin, end) and appends their results to out; returns the number of lines
+    // failed counts the lines with errors; errors, unless it is nullptr, gets what went wrong with each
+    size_t calculateChunk(MyInfixCalculator& calc, const char* text, size_t begin, size_t end, std::string& out,
+                          size_t& failed, std::vector<LineError>* errors) const
+    {
+        std::string line;
+        char result[64];
+        size_t lines = 0;
+        failed = 0;
+
+        while (begin < end){
+            const void* newline = std::memchr(text + begin, '\n', end - begin);
+            size_t stop = newline == nullptr ? end : static_cast<const char*>(newline) - text;
+
+            // accept files written with Windows line endings
+            size_t last = stop;
+            if (last > begin && text[last - 1] == '\r')
+                last--;
+
+            line.assign(text + begin, last - begin);
+            CalcResult r = calc.tryCalculate(line);
+            if (!r.ok()){
+                failed++;
+                if (errors != nullptr)
+                    errors->push_back(LineError{lines, begin, last - begin, r});
+            }
+            int n = std::snprintf(result, sizeof(result), "%.3f\n", r.value);
+            out.append(result, n);
+            lines++;
+            begin = stop + 1;
+        }
+        return lines;
+    }
+
+  public:
+    static const size_t CHUNK_BYTES = 64 * 1024;    // the text evaluated by one task; cut back to whole lines
+
+    // starts the given number of worker threads (at least one)
+    explicit MyBatchCalculator(size_t threads = std::thread::hardware_concurrency()) :
+        pool(threads)
+    {
+        // the calling thread helps the workers while it waits for them
+        for (size_t i = 0; i <= pool.size(); i++){
+            calculators.push_back(new MyInfixCalculator());
+        }
+    }
+
+    // the pool owns threads and cannot be copied
+    MyBatchCalculator(const MyBatchCalculator & rhs) = delete;
+    MyBatchCalculator & operator= (const MyBatchCalculator & rhs) = delete;
+
+    ~MyBatchCalculator()
+    {
+        for (auto calc : calculators){
+            delete calc;
+        }
+    }
+
+    // evaluates every line of text[0, length) as an expression and writes one result per line to out,
+    // formatted like the test program does; returns the number of lines
+    // a blank line is evaluated too, and reported as invalid, so that output line i belongs to input line i
+    // failures, unless it is nullptr, gets the number of lines with errors; the errors themselves go to
+    // errors as "Line n: " and the message calculate() would give, in the order of the lines
+    // with errors nullptr they are only counted, which costs next to nothing per line
+    size_t calculateLines(const char* text, size_t length, std::ostream& out, size_t* failures = nullptr,
+                          std::ostream* errors = &std::cerr)
+    {
+        size_t chunks = (length + CHUNK_BYTES - 1) / CHUNK_BYTES;
+        size_t window = 8 * (pool.size() + 1);       // chunks in flight at once; bounds the results kept in memory
+        std::vector<std::string> results(window);
+        std::vector<size_t> lines(window);
+        std::vector<size_t> failed(window);
+        std::vector<std::vector<LineError> > lineErrors(window);
+        size_t total = 0;
+        size_t totalFailed = 0;
+
+        for (size_t first = 0; first < chunks; first += window){
+            size_t count = chunks - first < window ? chunks - first : window;
+            pool.parallel_for(0, count, [&](size_t i){
+                size_t begin = lineStart(text, length, (first + i) * CHUNK_BYTES);
+                size_t end = lineStart(text, length, (first + i + 1) * CHUNK_BYTES);
+                results[i].clear();
+                lineErrors[i].clear();
+                lines[i] = calculateChunk(*calculators[pool.workerIndex()], text, begin, end, results[i], failed[i],
+                                          errors == nullptr ? nullptr : &lineErrors[i]);
+            });
+
+            // the window is complete, so its results can go out in order
+            for (size_t i = 0; i < count; i++){
+                out.write(results[i].data(), results[i].size());
+                for (const LineError& error : lineErrors[i]){
+                    *errors << "Line " << total + error.line + 1 << ": "
+                            << MyInfixCalculator::errorMessage(error.result, std::string(text + error.begin, error.length));
+                }
+                total += lines[i];
+                totalFailed += failed[i];
+            }
+        }
+
+        if (failures != nullptr)
+            *failures = totalFailed;
+        return total;
+    }
+
+    // maps the file at path and evaluates every line of it, see calculateLines()
+    // returns false if the file cannot be read
+    bool calculateFile(const std::string& path, std::ostream& out, size_t* lines = nullptr, size_t* failures = nullptr,
+                       std::ostream* errors = &std::cerr)
+    {
+        MyMappedFile file;
+        if (!file.open(path))
+            return false;
+
+        size_t n = calculateLines(file.data(), file.size(), out, failures, errors);
+        if (lines != nullptr)
+            *lines = n;
+        return true;
+    }
+
+    // access the number of worker threads
+    size_t threads() const
+    {
+        return pool.size();
+    }
+};
+
+
+#endif // __MYBATCHCALCULATOR_H__
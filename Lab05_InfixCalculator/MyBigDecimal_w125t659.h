@@ -0,0 +1,560 @@
+#ifndef __MYBIGDECIMAL_H__
+#define __MYBIGDECIMAL_H__
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// an exact decimal number of any size: a magnitude times 10^-scale, with a sign
+// the magnitude stays in one 128-bit integer (two machine words) for as long as it fits, 38 digits, and only
+// then moves to base 10^9 limbs, so everyday amounts and their quotients take a few machine instructions
+// +, - and * are exact; / is exact when the quotient ends within DIVISION_DIGITS digits after the point,
+// otherwise it is rounded there, half away from zero
+class MyBigDecimal
+{
+  public:
+    static const int DIVISION_DIGITS = 30;  // digits after the point that a quotient is rounded to
+
+  private:
+    typedef unsigned __int128 Word;
+    typedef std::vector<uint32_t> Limbs;   // base 10^9, least significant first, no leading zeros
+    static const uint32_t BASE = 1000000000;
+    static const int WORD_DIGITS = 38;      // every number of this many digits fits a Word
+
+    bool negative;
+    int scale;          // digits after the point
+    Word small;         // the magnitude while limbs is empty
+    Limbs limbs;        // the magnitude, once it outgrew small
+
+    // 10^n for n in [0, WORD_DIGITS]
+    static Word power10(int n)
+    {
+        struct Powers
+        {
+            Word p[WORD_DIGITS + 1];
+            Powers()
+            {
+                p[0] = 1;
+                for (int i = 1; i <= WORD_DIGITS; i++){
+                    p[i] = p[i - 1] * 10;
+                }
+            }
+        };
+        static const Powers powers;
+        return powers.p[n];
+    }
+
+    static Limbs toLimbs(Word n)
+    {
+        Limbs l;
+        while (n != 0){
+            l.push_back(static_cast<uint32_t>(n % BASE));
+            n /= BASE;
+        }
+        return l;
+    }
+
+    // the magnitude as limbs, whichever way it is stored
+    Limbs magnitude() const
+    {
+        return limbs.empty() ? toLimbs(small) : limbs;
+    }
+
+    // stores the magnitude m, back in small if it fits
+    void setMagnitude(Limbs& m)
+    {
+        while (!m.empty() && m.back() == 0){
+            m.pop_back();
+        }
+        if (m.size() <= 4){
+            small = 0;
+            for (size_t i = m.size(); i-- > 0;){
+                small = small * BASE + m[i];
+            }
+            limbs.clear();
+        }
+        else{
+            limbs.swap(m);
+        }
+    }
+
+    void setMagnitude(Word m)
+    {
+        small = m;
+        limbs.clear();
+    }
+
+    bool isSmall() const
+    {
+        return limbs.empty();
+    }
+
+    // m = m * factor + addend
+    static void multiplySmall(Limbs& m, uint32_t factor, uint32_t addend = 0)
+    {
+        uint64_t carry = addend;
+        for (size_t i = 0; i < m.size(); i++){
+            uint64_t x = static_cast<uint64_t>(m[i]) * factor + carry;
+            m[i] = static_cast<uint32_t>(x % BASE);
+            carry = x / BASE;
+        }
+        while (carry != 0){
+            m.push_back(static_cast<uint32_t>(carry % BASE));
+            carry /= BASE;
+        }
+    }
+
+    // m = m / divisor; returns the remainder
+    static uint32_t divideSmall(Limbs& m, uint32_t divisor)
+    {
+        uint64_t remainder = 0;
+        for (size_t i = m.size(); i-- > 0;){
+            uint64_t x = remainder * BASE + m[i];
+            m[i] = static_cast<uint32_t>(x / divisor);
+            remainder = x % divisor;
+        }
+        while (!m.empty() && m.back() == 0){
+            m.pop_back();
+        }
+        return static_cast<uint32_t>(remainder);
+    }
+
+    static void multiplyPower10(Limbs& m, int n)
+    {
+        for (; n >= 9; n -= 9){
+            m.insert(m.begin(), 0);
+        }
+        if (n > 0)
+            multiplySmall(m, static_cast<uint32_t>(power10(n)));
+        while (!m.empty() && m.back() == 0){
+            m.pop_back();
+        }
+    }
+
+    static int compareMagnitudes(const Limbs& a, const Limbs& b)
+    {
+        if (a.size() != b.size())
+            return a.size() < b.size() ? -1 : 1;
+        for (size_t i = a.size(); i-- > 0;){
+            if (a[i] != b[i])
+                return a[i] < b[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // a += b
+    static void addMagnitudes(Limbs& a, const Limbs& b)
+    {
+        if (a.size() < b.size())
+            a.resize(b.size(), 0);
+        uint32_t carry = 0;
+        for (size_t i = 0; i < a.size(); i++){
+            uint32_t x = a[i] + carry + (i < b.size() ? b[i] : 0);
+            carry = x >= BASE ? 1 : 0;
+            a[i] = x - carry * BASE;
+            if (carry == 0 && i >= b.size())
+                break;
+        }
+        if (carry != 0)
+            a.push_back(carry);
+    }
+
+    // a -= b; a must not be smaller than b
+    static void subtractMagnitudes(Limbs& a, const Limbs& b)
+    {
+        int64_t borrow = 0;
+        for (size_t i = 0; i < a.size(); i++){
+            int64_t x = static_cast<int64_t>(a[i]) - borrow - (i < b.size() ? b[i] : 0);
+            borrow = x < 0 ? 1 : 0;
+            a[i] = static_cast<uint32_t>(x + borrow * BASE);
+        }
+        while (!a.empty() && a.back() == 0){
+            a.pop_back();
+        }
+    }
+
+    static Limbs multiplyMagnitudes(const Limbs& a, const Limbs& b)
+    {
+        if (a.empty() || b.empty())
+            return Limbs();
+
+        std::vector<uint64_t> product(a.size() + b.size(), 0);
+        for (size_t i = 0; i < a.size(); i++){
+            uint64_t carry = 0;
+            for (size_t j = 0; j < b.size(); j++){
+                uint64_t x = product[i + j] + static_cast<uint64_t>(a[i]) * b[j] + carry;
+                product[i + j] = x % BASE;
+                carry = x / BASE;
+            }
+            product[i + b.size()] += carry;
+        }
+
+        Limbs result(product.begin(), product.end());
+        while (!result.empty() && result.back() == 0){
+            result.pop_back();
+        }
+        return result;
+    }
+
+    // quotient = n / d, remainder = n % d; d must not be zero
+    // schoolbook division, one limb of the quotient at a time, each found by bisection
+    static void divideMagnitudes(const Limbs& n, const Limbs& d, Limbs& quotient, Limbs& remainder)
+    {
+        quotient.assign(n.size(), 0);
+        remainder.clear();
+        Limbs product;
+        for (size_t i = n.size(); i-- > 0;){
+            multiplySmall(remainder, BASE, n[i]);
+
+            uint32_t low = 0, high = BASE - 1;
+            while (low < high){
+                uint32_t mid = low + (high - low + 1) / 2;
+                product = d;
+                multiplySmall(product, mid);
+                if (compareMagnitudes(product, remainder) <= 0)
+                    low = mid;
+                else
+                    high = mid - 1;
+            }
+            quotient[i] = low;
+            if (low != 0){
+                product = d;
+                multiplySmall(product, low);
+                subtractMagnitudes(remainder, product);
+            }
+        }
+        while (!quotient.empty() && quotient.back() == 0){
+            quotient.pop_back();
+        }
+    }
+
+    // raises the scale to s, which must not be smaller, without changing the value
+    void rescale(int s)
+    {
+        int n = s - scale;
+        if (n == 0)
+            return;
+        Word m;
+        if (isSmall() && n <= WORD_DIGITS && !__builtin_mul_overflow(small, power10(n), &m))
+            small = m;
+        else{
+            Limbs m = magnitude();
+            multiplyPower10(m, n);
+            setMagnitude(m);
+        }
+        scale = s;
+    }
+
+    // drops zeros at the end of the digits after the point
+    void trim()
+    {
+        if (isSmall()){
+            if (small != 0){
+                while (scale >= 9 && small % BASE == 0){
+                    small /= BASE;
+                    scale -= 9;
+                }
+                while (scale > 0 && small % 10 == 0){
+                    small /= 10;
+                    scale--;
+                }
+            }
+        }
+        else{
+            while (scale >= 9 && limbs[0] == 0){
+                limbs.erase(limbs.begin());
+                scale -= 9;
+            }
+            while (scale > 0 && limbs[0] % 10 == 0){
+                divideSmall(limbs, 10);
+                scale--;
+            }
+            Limbs m;
+            m.swap(limbs);
+            setMagnitude(m);
+        }
+        if (isZero()){
+            scale = 0;
+            negative = false;
+        }
+    }
+
+    // adds rhs, or subtracts it if flip is set
+    void addSigned(const MyBigDecimal& rhs, bool flip)
+    {
+        bool rhsNegative = rhs.negative != flip && !rhs.isZero();
+        if (scale < rhs.scale)
+            rescale(rhs.scale);
+        else if (rhs.scale < scale){
+            MyBigDecimal r(rhs);
+            r.rescale(scale);
+            addSigned(r, flip);
+            return;
+        }
+
+        // both in machine words: one 128-bit addition or subtraction
+        Word sum;
+        if (isSmall() && rhs.isSmall() && (negative != rhsNegative || !__builtin_add_overflow(small, rhs.small, &sum))){
+            if (negative == rhsNegative)
+                small = sum;
+            else if (small >= rhs.small)
+                small -= rhs.small;
+            else{
+                small = rhs.small - small;
+                negative = rhsNegative;
+            }
+        }
+        else{
+            Limbs a = magnitude();
+            Limbs b = rhs.magnitude();
+            if (negative == rhsNegative)
+                addMagnitudes(a, b);
+            else if (compareMagnitudes(a, b) >= 0)
+                subtractMagnitudes(a, b);
+            else{
+                subtractMagnitudes(b, a);
+                a.swap(b);
+                negative = rhsNegative;
+            }
+            setMagnitude(a);
+        }
+        if (isZero())
+            negative = false;
+    }
+
+  public:
+
+    MyBigDecimal() :
+        negative{false},
+        scale{0},
+        small{0}
+    {
+        ;
+    }
+
+    // reads a decimal literal, digits with at most one point and an optional leading minus,
+    // the way the calculator's tokenizer writes them; returns false if there is no number
+    static bool parse(const char* text, size_t length, MyBigDecimal& value)
+    {
+        value = MyBigDecimal();
+        size_t i = 0;
+        bool negative = length > 0 && text[0] == '-';
+        if (negative)
+            i++;
+
+        bool digits = false;
+        bool point = false;
+        Limbs m;
+        for (; i < length; i++){
+            char c = text[i];
+            if (c == '.'){
+                if (point)
+                    break;
+                point = true;
+                continue;
+            }
+            if (c < '0' || c > '9')
+                break;
+            digits = true;
+            if (point)
+                value.scale++;
+
+            // the fast path: stay in small until another digit would not fit
+            if (m.empty() && value.small <= (~static_cast<Word>(0) - 9) / 10){
+                value.small = value.small * 10 + (c - '0');
+                continue;
+            }
+            if (m.empty())
+                m = toLimbs(value.small);
+            multiplySmall(m, 10, c - '0');
+        }
+        if (!digits)
+            return false;
+
+        if (!m.empty())
+            value.setMagnitude(m);
+        value.negative = negative && !value.isZero();
+        return true;
+    }
+
+    // the exact value of a double, which is a binary fraction and so also a finite decimal
+    // returns false if it is not finite
+    static bool fromDouble(double d, MyBigDecimal& value)
+    {
+        if (!std::isfinite(d))
+            return false;
+
+        value = MyBigDecimal();
+        int exponent;
+        double fraction = std::frexp(std::fabs(d), &exponent);
+        uint64_t mantissa = static_cast<uint64_t>(std::ldexp(fraction, 53));
+        exponent -= 53;
+
+        Limbs m = toLimbs(mantissa);
+        if (exponent >= 0){
+            for (int i = 0; i < exponent; i++){
+                multiplySmall(m, 2);
+            }
+        }
+        else{
+            // m * 2^e is m * 5^-e / 10^-e
+            for (int i = 0; i < -exponent; i++){
+                multiplySmall(m, 5);
+            }
+            value.scale = -exponent;
+        }
+        value.setMagnitude(m);
+        value.negative = d < 0;
+        value.trim();
+        return true;
+    }
+
+    // the nearest double
+    double toDouble() const
+    {
+        return std::strtod(toString().c_str(), nullptr);
+    }
+
+    // the exact value, without zeros at the end of the digits after the point
+    std::string toString() const
+    {
+        std::string digits;
+        if (isSmall()){
+            Word m = small;
+            do{
+                digits += static_cast<char>('0' + static_cast<int>(m % 10));
+                m /= 10;
+            } while (m != 0);
+            digits.assign(digits.rbegin(), digits.rend());
+        }
+        else{
+            digits = std::to_string(limbs.back());
+            for (size_t i = limbs.size() - 1; i-- > 0;){
+                std::string limb = std::to_string(limbs[i]);
+                digits.append(9 - limb.length(), '0');
+                digits += limb;
+            }
+        }
+
+        size_t fraction = static_cast<size_t>(scale);
+        if (digits.length() <= fraction)
+            digits.insert(0, fraction + 1 - digits.length(), '0');
+        if (fraction > 0){
+            digits.insert(digits.length() - fraction, 1, '.');
+            while (digits.back() == '0'){
+                digits.pop_back();
+            }
+            if (digits.back() == '.')
+                digits.pop_back();
+        }
+        return negative ? "-" + digits : digits;
+    }
+
+    bool isZero() const
+    {
+        return isSmall() && small == 0;
+    }
+
+    // returns a negative number, zero or a positive number as this is less than, equal to or greater than rhs
+    int compare(const MyBigDecimal& rhs) const
+    {
+        bool lhsNegative = negative && !isZero();
+        bool rhsNegative = rhs.negative && !rhs.isZero();
+        if (lhsNegative != rhsNegative)
+            return lhsNegative ? -1 : 1;
+
+        int magnitudes;
+        if (scale == rhs.scale && isSmall() && rhs.isSmall())
+            magnitudes = small < rhs.small ? -1 : small > rhs.small ? 1 : 0;
+        else{
+            MyBigDecimal a(*this), b(rhs);
+            int s = scale > rhs.scale ? scale : rhs.scale;
+            a.rescale(s);
+            b.rescale(s);
+            magnitudes = compareMagnitudes(a.magnitude(), b.magnitude());
+        }
+        return lhsNegative ? -magnitudes : magnitudes;
+    }
+
+    // the operations never overflow; they return true to match the other numeric types of the calculator
+    bool negate()
+    {
+        negative = !negative && !isZero();
+        return true;
+    }
+
+    bool add(const MyBigDecimal& rhs)
+    {
+        addSigned(rhs, false);
+        return true;
+    }
+
+    bool subtract(const MyBigDecimal& rhs)
+    {
+        addSigned(rhs, true);
+        return true;
+    }
+
+    bool multiply(const MyBigDecimal& rhs)
+    {
+        Word product;
+        if (isSmall() && rhs.isSmall() && !__builtin_mul_overflow(small, rhs.small, &product))
+            small = product;
+        else{
+            Limbs m = multiplyMagnitudes(magnitude(), rhs.magnitude());
+            setMagnitude(m);
+        }
+        scale += rhs.scale;
+        negative = negative != rhs.negative;
+        trim();
+        return true;
+    }
+
+    // rhs must not be zero
+    bool divide(const MyBigDecimal& rhs)
+    {
+        // the quotient n / d, with n and d scaled so that it comes out with DIVISION_DIGITS digits after the point
+        int shift = DIVISION_DIGITS + rhs.scale - scale;
+        bool resultNegative = negative != rhs.negative;
+
+        // the fast path: the scaled dividend fits 128 bits
+        Word scaled;
+        if (isSmall() && rhs.isSmall() && shift >= 0 && shift <= WORD_DIGITS && !__builtin_mul_overflow(small, power10(shift), &scaled)){
+            Word q = scaled / rhs.small;
+            Word r = scaled % rhs.small;
+            if (r >= rhs.small - r)
+                q++;
+            small = q;
+            scale = DIVISION_DIGITS;
+            negative = resultNegative;
+            trim();
+            return true;
+        }
+
+        Limbs n = magnitude();
+        Limbs d = rhs.magnitude();
+        if (shift >= 0)
+            multiplyPower10(n, shift);
+        else
+            multiplyPower10(d, -shift);
+
+        Limbs q, r;
+        divideMagnitudes(n, d, q, r);
+        multiplySmall(r, 2);
+        if (compareMagnitudes(r, d) >= 0){
+            Limbs one(1, 1);
+            addMagnitudes(q, one);
+        }
+        setMagnitude(q);
+        scale = DIVISION_DIGITS;
+        negative = resultNegative;
+        trim();
+        return true;
+    }
+};
+
+
+#endif // __MYBIGDECIMAL_H__
@@ -0,0 +1,181 @@
+#ifndef __MYFIXEDPOINT_H__
+#define __MYFIXEDPOINT_H__
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// a decimal number with a fixed number of digits after the point, held as a count of 10^-Decimals units
+// in one 64-bit integer; + and - are exact, * and / round the last digit half away from zero
+// with 4 decimals the range is about +-9.2 * 10^14; the operations return false when they would overflow
+template <int Decimals = 4>
+class MyFixedPoint
+{
+    static_assert(Decimals >= 0 && Decimals <= 18, "the units of a MyFixedPoint must fit 64 bits");
+
+  private:
+    int64_t units;      // the value times 10^Decimals
+
+    static int64_t scale()
+    {
+        int64_t s = 1;
+        for (int i = 0; i < Decimals; i++){
+            s *= 10;
+        }
+        return s;
+    }
+
+    // divides n by d, rounding half away from zero; returns false if the quotient does not fit
+    static bool roundedQuotient(__int128 n, __int128 d, int64_t& q)
+    {
+        __int128 quotient = n / d;
+        __int128 remainder = n % d;
+        if (remainder < 0)
+            remainder = -remainder;
+        if (2 * remainder >= (d < 0 ? -d : d))
+            quotient += (n < 0) != (d < 0) ? -1 : 1;
+
+        if (quotient > INT64_MAX || quotient < INT64_MIN)
+            return false;
+        q = static_cast<int64_t>(quotient);
+        return true;
+    }
+
+  public:
+
+    MyFixedPoint() :
+        units{0}
+    {
+        ;
+    }
+
+    // reads a decimal literal, digits with at most one point and an optional leading minus,
+    // the way the calculator's tokenizer writes them; digits past Decimals are rounded
+    // returns false if there is no number or it is out of range
+    static bool parse(const char* text, size_t length, MyFixedPoint& value)
+    {
+        size_t i = 0;
+        bool negative = length > 0 && text[0] == '-';
+        if (negative)
+            i++;
+
+        __int128 whole = 0;         // the digits before the point
+        int64_t fraction = 0;       // the first Decimals digits after it
+        int fractionDigits = 0;
+        bool digits = false;
+        bool point = false;
+        bool roundUp = false;       // the first digit past Decimals is 5 or more
+        for (; i < length; i++){
+            char c = text[i];
+            if (c == '.'){
+                if (point)
+                    break;
+                point = true;
+                continue;
+            }
+            if (c < '0' || c > '9')
+                break;
+            digits = true;
+
+            if (!point){
+                whole = whole * 10 + (c - '0');
+                if (whole > INT64_MAX)
+                    return false;
+            }
+            else if (fractionDigits < Decimals){
+                fraction = fraction * 10 + (c - '0');
+                fractionDigits++;
+            }
+            else if (fractionDigits == Decimals){
+                roundUp = c >= '5';
+                fractionDigits++;
+            }
+        }
+        if (!digits)
+            return false;
+
+        for (int f = fractionDigits; f < Decimals; f++){
+            fraction *= 10;
+        }
+        __int128 units = whole * scale() + fraction + (roundUp ? 1 : 0);
+        if (units > INT64_MAX)
+            return false;
+
+        value.units = negative ? -static_cast<int64_t>(units) : static_cast<int64_t>(units);
+        return true;
+    }
+
+    // the nearest fixed-point value to a double; returns false if it is not finite or out of range
+    static bool fromDouble(double d, MyFixedPoint& value)
+    {
+        double u = std::round(d * static_cast<double>(scale()));
+        if (!(u > -9.2e18 && u < 9.2e18))
+            return false;
+        value.units = static_cast<int64_t>(u);
+        return true;
+    }
+
+    double toDouble() const
+    {
+        return static_cast<double>(units) / static_cast<double>(scale());
+    }
+
+    // the exact value, with all Decimals digits after the point
+    std::string toString() const
+    {
+        uint64_t magnitude = units < 0 ? 0 - static_cast<uint64_t>(units) : static_cast<uint64_t>(units);
+        std::string digits = std::to_string(magnitude);
+        if (digits.length() <= static_cast<size_t>(Decimals))
+            digits.insert(0, Decimals + 1 - digits.length(), '0');
+
+        std::string s = units < 0 ? "-" : "";
+        s += digits.substr(0, digits.length() - Decimals);
+        if (Decimals > 0)
+            s += "." + digits.substr(digits.length() - Decimals);
+        return s;
+    }
+
+    bool isZero() const
+    {
+        return units == 0;
+    }
+
+    // returns a negative number, zero or a positive number as this is less than, equal to or greater than rhs
+    int compare(const MyFixedPoint& rhs) const
+    {
+        return units < rhs.units ? -1 : units > rhs.units ? 1 : 0;
+    }
+
+    bool negate()
+    {
+        if (units == INT64_MIN)
+            return false;
+        units = -units;
+        return true;
+    }
+
+    bool add(const MyFixedPoint& rhs)
+    {
+        return !__builtin_add_overflow(units, rhs.units, &units);
+    }
+
+    bool subtract(const MyFixedPoint& rhs)
+    {
+        return !__builtin_sub_overflow(units, rhs.units, &units);
+    }
+
+    bool multiply(const MyFixedPoint& rhs)
+    {
+        return roundedQuotient(static_cast<__int128>(units) * rhs.units, scale(), units);
+    }
+
+    // rhs must not be zero
+    bool divide(const MyFixedPoint& rhs)
+    {
+        return roundedQuotient(static_cast<__int128>(units) * scale(), rhs.units, units);
+    }
+};
+
+
+#endif // __MYFIXEDPOINT_H__
@@ -0,0 +1,313 @@
+#ifndef __MYFORMULAGRAPH_H__
+#define __MYFORMULAGRAPH_H__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MyInfixCalculator_w125t659.h"
+#include "MyThreadPool_w125t659.h"
+
+// named cells, like those of a spreadsheet, holding either a value or a formula over other cells
+// every formula is compiled once; a variable of a formula is the cell of that name
+// changing a cell only marks it; recalculate() then runs the cells downstream of the changes, and no others,
+// in topological order, one wave of mutually independent cells at a time, spread over a thread pool
+// when a wave is wide enough
+class MyFormulaGraph
+{
+  private:
+    struct Cell
+    {
+        CompiledExpression formula;     // not valid for a value cell
+        bool hasFormula;
+        std::vector<size_t> inputs;     // inputs[i] is the cell bound to variable slot i of formula
+        std::vector<size_t> dependents; // the cells whose formula uses this one
+        CalcResult result;
+        unsigned visited;               // the recalculation that last found the cell dirty
+        size_t pending;                 // dirty inputs not recalculated yet, during a recalculation
+    };
+
+    MyInfixCalculator calculator;
+    MyThreadPool* pool;                 // nullptr when the graph is recalculated on the calling thread only
+    std::vector<Cell> cells;
+    std::unordered_map<std::string, size_t> names;
+    std::vector<size_t> changed;        // cells set since the last recalculation
+    unsigned recalculations;
+
+    // a cell that was referred to but never set; it has no value
+    static CalcResult undefined()
+    {
+        CalcResult result;
+        result.error = CalcError::UNBOUND_VARIABLE;
+        return result;
+    }
+
+    // checks if a cell's result can be used by the formulas over it; a skipped character leaves a value
+    static bool hasValue(const CalcResult& result)
+    {
+        return result.ok() || result.error == CalcError::INVALID_CHARACTER || result.error == CalcError::INVALID_NUMBER;
+    }
+
+    // stops cell from being a dependent of its inputs
+    void detach(size_t cell)
+    {
+        for (size_t input : cells[cell].inputs){
+            std::vector<size_t>& d = cells[input].dependents;
+            for (size_t i = 0; i < d.size(); i++){
+                if (d[i] == cell){
+                    d[i] = d.back();
+                    d.pop_back();
+                    break;
+                }
+            }
+        }
+        cells[cell].inputs.clear();
+    }
+
+    // runs the formula of a cell over the current results of its inputs
+    void evaluateCell(size_t cell)
+    {
+        Cell& c = cells[cell];
+        if (!c.hasFormula)
+            return;
+        if (!c.formula.valid){
+            c.result = c.formula.status;
+            return;
+        }
+
+        double local[16];
+        std::vector<double> heap;
+        double* bindings = local;
+        if (c.inputs.size() > 16){
+            heap.resize(c.inputs.size());
+            bindings = heap.data();
+        }
+
+        // a cycle upstream makes this cell part of the problem; otherwise an input without a value is unbound
+        size_t unbound = c.inputs.size();
+        for (size_t i = 0; i < c.inputs.size(); i++){
+            const CalcResult& input = cells[c.inputs[i]].result;
+            if (input.error == CalcError::CIRCULAR_REFERENCE){
+                c.result = input;
+                return;
+            }
+            if (!hasValue(input) && unbound == c.inputs.size())
+                unbound = i;
+            bindings[i] = input.value;
+        }
+
+        if (unbound < c.inputs.size()){
+            // point at the variable whose cell has no value
+            CalcResult result;
+            result.error = CalcError::UNBOUND_VARIABLE;
+            result.length = static_cast<unsigned>(c.formula.variables[unbound].length());
+            for (const Instruction& ins : c.formula.code){
+                if (ins.op == OpCode::LOAD && ins.slot == unbound){
+                    result.position = ins.position;
+                    break;
+                }
+            }
+            c.result = result;
+            return;
+        }
+        c.result = calculator.tryEvaluate(c.formula, bindings);
+    }
+
+    // runs every cell of one wave; the cells of a wave do not depend on each other
+    void evaluateWave(const std::vector<size_t>& wave)
+    {
+        if (pool != nullptr && wave.size() >= PARALLEL_WAVE){
+            pool->parallel_for(0, wave.size(), [this, &wave](size_t i){
+                evaluateCell(wave[i]);
+            }, PARALLEL_WAVE / 4);
+        }
+        else{
+            for (size_t cell : wave){
+                evaluateCell(cell);
+            }
+        }
+    }
+
+  public:
+    static const size_t PARALLEL_WAVE = 4096;    // the fewest cells of a wave worth handing to the thread pool
+
+    // recalculates on the given number of worker threads; with none, on the calling thread only
+    explicit MyFormulaGraph(size_t threads = 0) :
+        calculator(0),
+        pool{threads == 0 ? nullptr : new MyThreadPool(threads)},
+        recalculations{0}
+    {
+        ;
+    }
+
+    // the pool owns threads and cannot be copied
+    MyFormulaGraph(const MyFormulaGraph & rhs) = delete;
+    MyFormulaGraph & operator= (const MyFormulaGraph & rhs) = delete;
+
+    ~MyFormulaGraph()
+    {
+        delete pool;
+    }
+
+    // returns the index of the named cell, creating a cell without a value if there is none yet
+    size_t cell(const std::string& name)
+    {
+        auto found = names.find(name);
+        if (found != names.end())
+            return found->second;
+
+        Cell c;
+        c.hasFormula = false;
+        c.result = undefined();
+        c.visited = 0;
+        c.pending = 0;
+        cells.push_back(c);
+        names.emplace(name, cells.size() - 1);
+        return cells.size() - 1;
+    }
+
+    // makes the named cell hold a value
+    void setValue(const std::string& name, double value)
+    {
+        setValue(cell(name), value);
+    }
+
+    void setValue(size_t index, double value)
+    {
+        detach(index);
+        Cell& c = cells[index];
+        c.formula = CompiledExpression();
+        c.hasFormula = false;
+        c.result = CalcResult();
+        c.result.value = value;
+        changed.push_back(index);
+    }
+
+    // makes the named cell compute formula, whose variables name other cells
+    // returns false if formula does not compile; the cell then has its error as its result
+    bool setFormula(const std::string& name, const std::string& formula)
+    {
+        size_t index = cell(name);
+        detach(index);
+
+        // a formula that does not compile has its error whatever its variables hold, so it has no inputs
+        CompiledExpression compiled = calculator.compile(formula);
+        compiled.code.shrink_to_fit();          // cells are many and kept for long
+        compiled.variables.shrink_to_fit();
+        std::vector<size_t> inputs;
+        if (compiled.valid){
+            for (const std::string& variable : compiled.variables){
+                inputs.push_back(cell(variable));
+            }
+        }
+
+        // cell() may have grown cells, so it is indexed again rather than held
+        for (size_t input : inputs){
+            cells[input].dependents.push_back(index);
+        }
+        cells[index].formula = std::move(compiled);
+        cells[index].hasFormula = true;
+        cells[index].inputs = std::move(inputs);
+        changed.push_back(index);
+        return cells[index].formula.valid;
+    }
+
+    // recalculates every cell downstream of a cell set since the last call, each once and after its inputs
+    // cells on a cycle, and the cells downstream of one, get CIRCULAR_REFERENCE
+    // returns the number of cells recalculated
+    size_t recalculate()
+    {
+        if (changed.empty())
+            return 0;
+        recalculations++;
+
+        // the dirty subgraph: everything reachable from the changed cells through dependents
+        std::vector<size_t> dirty;
+        for (size_t cell : changed){
+            if (cells[cell].visited != recalculations){
+                cells[cell].visited = recalculations;
+                dirty.push_back(cell);
+            }
+        }
+        changed.clear();
+        for (size_t i = 0; i < dirty.size(); i++){
+            for (size_t d : cells[dirty[i]].dependents){
+                if (cells[d].visited != recalculations){
+                    cells[d].visited = recalculations;
+                    dirty.push_back(d);
+                }
+            }
+        }
+
+        // Kahn's algorithm over the dirty subgraph; a wave is every cell whose dirty inputs are all done
+        for (size_t cell : dirty){
+            cells[cell].pending = 0;
+        }
+        for (size_t cell : dirty){
+            for (size_t d : cells[cell].dependents){
+                cells[d].pending++;
+            }
+        }
+
+        std::vector<size_t> wave;
+        std::vector<size_t> next;
+        for (size_t cell : dirty){
+            if (cells[cell].pending == 0)
+                wave.push_back(cell);
+        }
+
+        size_t done = 0;
+        while (!wave.empty()){
+            evaluateWave(wave);
+            done += wave.size();
+
+            next.clear();
+            for (size_t cell : wave){
+                for (size_t d : cells[cell].dependents){
+                    if (--cells[d].pending == 0)
+                        next.push_back(d);
+                }
+            }
+            wave.swap(next);
+        }
+
+        // whatever never became ready waits on a cycle
+        if (done < dirty.size()){
+            for (size_t cell : dirty){
+                if (cells[cell].pending != 0){
+                    cells[cell].result = CalcResult();
+                    cells[cell].result.error = CalcError::CIRCULAR_REFERENCE;
+                }
+            }
+        }
+        return dirty.size();
+    }
+
+    // access the result of the named cell as of the last recalculate(); an unknown cell has no value
+    CalcResult result(const std::string& name) const
+    {
+        auto found = names.find(name);
+        return found == names.end() ? undefined() : cells[found->second].result;
+    }
+
+    CalcResult result(size_t index) const
+    {
+        return cells[index].result;
+    }
+
+    // access the value of the named cell; 0.0 if it has none
+    double value(const std::string& name) const
+    {
+        CalcResult r = result(name);
+        return hasValue(r) ? r.value : 0.0;
+    }
+
+    // access the number of cells, including those referred to but never set
+    size_t size() const
+    {
+        return cells.size();
+    }
+};
+
+
+#endif // __MYFORMULAGRAPH_H__
@@ -2,16 +2,193 @@
 #define __MYINFIXCALCULATOR_H__
 
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <istream>
+#include <new>
 #include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 #include "MyStack_w125t659.h"
 #include "MyVector_w125t659.h"
+#include "MyLRUCache_w125t659.h"
+#include "MyOperatorTable_w125t659.h"
+
+// what went wrong with an expression
+enum class CalcError : unsigned char
+{
+    NONE,
+    INVALID_CHARACTER,      // a character that belongs to no token; skipped
+    INVALID_NUMBER,         // digits and points that do not make a number, such as "."; skipped
+    MISSING_OPERAND,        // an operator, or a parenthesis never closed, without enough operands
+    UNCLOSED_PARENTHESIS,   // a parenthesis never closed, after enough operands
+    INVALID_EXPRESSION,     // operands left over, or none at all
+    UNBOUND_VARIABLE,
+    DIVISION_BY_ZERO,
+    OUT_OF_RANGE,           // a result the numeric type of evaluateAs() cannot hold
+    CIRCULAR_REFERENCE,     // a cell of a MyFormulaGraph that depends on itself
+    FOLDED_CONSTANT         // a constant optimize() computed in double, which evaluateAs() cannot run exactly
+};
+
+// the outcome of calculating an expression: its value, or what went wrong and where
+// position and length locate the offending token in the source text; length is 0 where the error
+// is not about one token, e.g. INVALID_EXPRESSION
+// a skipped character or number is reported, yet the rest of the expression still has its value,
+// which calculate() returns as it always did; every other error leaves value 0.0
+struct CalcResult
+{
+    double value = 0.0;
+    CalcError error = CalcError::NONE;
+    unsigned position = 0;
+    unsigned length = 0;
+
+    bool ok() const
+    {
+        return error == CalcError::NONE;
+    }
+};
+
+// one step of a compiled expression
+struct Instruction
+{
+    OpCode op;
+    unsigned position;  // where the token it came from starts in the source text, for error reports
+    double value;       // the operand of PUSH; unused by the other opcodes
+    size_t slot;        // the variable slot read by LOAD, the temporary of SAVE and TEMP,
+                        // the operatorTable() entry of an operator, or where the text of a PUSH operand
+                        // starts in CompiledExpression::literals (NO_LITERAL for a constant optimize() folded)
+};
+
+// the slot of a PUSH whose operand has no text, as optimize() computed it in double
+static const size_t NO_LITERAL = static_cast<size_t>(-1);
+
+// an expression translated once into postfix bytecode
+// evaluating it never looks at the source text again
+struct CompiledExpression
+{
+    MyVector<Instruction> code;
+    MyVector<std::string> variables;    // variables[i] is the name of the variable bound to slot i
+    std::string literals;   // the source text of every number, each followed by a space, for exact evaluation;
+                            // optimize() keeps it for the numbers it does not fold
+    size_t maxDepth = 0;    // the deepest the operand stack gets while evaluating code
+    size_t temporaries = 0; // the number of temporaries used by SAVE and TEMP
+    bool valid = false;     // false if the expression could not be compiled
+    CalcResult status;      // why it could not be, or the first character or number compile() skipped
+
+    // returns the slot of the named variable; -1 if the expression does not use it
+    int slot(const std::string& name) const
+    {
+        return slot(name.data(), name.length());
+    }
+
+    int slot(const char* name, size_t length) const
+    {
+        for (size_t i = 0; i < variables.size(); i++){
+            if (variables[i].length() == length && variables[i].compare(0, length, name, length) == 0)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+};
+
+// the kinds of token an infix expression is made of
+enum class TokenKind : unsigned char
+{
+    NUMBER,
+    VARIABLE,
+    OPERATOR,
+    FUNCTION,
+    LEFT_PARENTHESIS,
+    RIGHT_PARENTHESIS,
+    COMMA
+};
+
+// one token of an infix expression; small, trivially copyable and never owns memory
+struct Token
+{
+    TokenKind kind;
+    int op;                 // the operatorTable() entry of an OPERATOR or FUNCTION
+    double value;           // the value of a NUMBER, parsed once by the tokenizer
+    const char* name;       // the name of a VARIABLE or the text of a NUMBER; points into the source text,
+                            // not null-terminated
+    size_t length;          // how many characters of the source text the token is
+    unsigned position;      // where it starts in the source text
+};
+
+// how evaluateAs() computes with a numeric type
+// by default it calls the members of Number, as MyFixedPoint and MyBigDecimal have them: parse() (for literal()), fromDouble(),
+// toDouble(), isZero(), compare(), negate(), add(), subtract(), multiply() and divide(), the last five returning
+// false on overflow; a default-constructed Number must be zero
+template <typename Number>
+struct NumberTraits
+{
+    // a number of the expression, given its text and the double compile() read from it
+    static bool literal(const char* text, size_t length, double, Number& value) { return Number::parse(text, length, value); }
+    // a constant optimize() computed in double, which has no text; a type that computes exactly refuses it
+    static bool folded(double, Number&) { return false; }
+    static bool fromDouble(double d, Number& value) { return Number::fromDouble(d, value); }
+    static double toDouble(const Number& value) { return value.toDouble(); }
+    static bool isZero(const Number& value) { return value.isZero(); }
+    static int compare(const Number& a, const Number& b) { return a.compare(b); }
+    static bool negate(Number& a) { return a.negate(); }
+    static bool add(Number& a, const Number& b) { return a.add(b); }
+    static bool subtract(Number& a, const Number& b) { return a.subtract(b); }
+    static bool multiply(Number& a, const Number& b) { return a.multiply(b); }
+    static bool divide(Number& a, const Number& b) { return a.divide(b); }
+};
+
+// double itself, so that evaluateAs<double>() computes what evaluate() does
+template <>
+struct NumberTraits<double>
+{
+    static bool literal(const char*, size_t, double d, double& value) { value = d; return true; }
+    static bool folded(double d, double& value) { value = d; return true; }
+    static bool fromDouble(double d, double& value) { value = d; return true; }
+    static double toDouble(const double& value) { return value; }
+    static bool isZero(const double& value) { return value == 0; }
+    static int compare(const double& a, const double& b) { return a < b ? -1 : a > b ? 1 : 0; }
+    static bool negate(double& a) { a = -a; return true; }
+    static bool add(double& a, const double& b) { a += b; return true; }
+    static bool subtract(double& a, const double& b) { a -= b; return true; }
+    static bool multiply(double& a, const double& b) { a *= b; return true; }
+    static bool divide(double& a, const double& b) { a /= b; return true; }
+};
+
+// a compiled expression made ready for evaluateAs() in one numeric type (see MyInfixCalculator::prepareAs)
+// its numbers are converted from their text once, so running it again and again parses none of them
+template <typename Number>
+struct PreparedExpression
+{
+    CompiledExpression expression;  // the program, each PUSH slot indexing constants rather than literals
+    std::vector<Number> constants;  // the numbers of the program, in Number
+    CalcResult conversion;          // why a number of the program has no value in Number, if one has not
+};
 
 class MyInfixCalculator{
 
   public:
+
+    static const size_t LOCAL_STACK = 64;   // operand stack depth that evaluate() keeps on the C++ stack
+    static const size_t BATCH_BLOCK = 256;  // rows evaluateBatch() runs through each instruction at a time
+
+    // how evaluate() gets from one instruction to the next
+    enum class Dispatch
+    {
+        THREADED,   // every handler jumps straight to the next one through a table of labels (computed goto)
+        SWITCH      // one switch in a loop; portable C++
+    };
     
-    MyInfixCalculator()
+    // keeps the compiled form of the cacheCapacity most recently calculated expressions
+    explicit MyInfixCalculator(size_t cacheCapacity = 64) :
+        cache(cacheCapacity)
     {
 
     }
@@ -21,51 +198,850 @@ class MyInfixCalculator{
 
     }
 
+    // calculates the value of an infix expression
+    // an expression seen recently is not parsed again; only its cached bytecode is run
+    // errors are written to std::cerr and give 0.0; see tryCalculate() to tell them from a real zero
     double calculate(const std::string& s)
     {
-        MyVector<std::string> infix_tokens;
-        MyVector<std::string> postfix_tokens;
-        
-        tokenize(s, infix_tokens);
-        infixToPostfix(infix_tokens, postfix_tokens);
-        return calPostfix(postfix_tokens);
+        CalcResult result = tryCalculate(s);
+        if (!result.ok())
+            std::cerr << errorMessage(result, s);
+        return result.value;
+    }
+
+    // calculates the value of an infix expression, or finds what is wrong with it, without any I/O,
+    // so that a caller going through many expressions can count and report failures as it likes
+    CalcResult tryCalculate(const std::string& s)
+    {
+        if (cache.capacity() == 0)
+            return tryEvaluate(compile(s), nullptr);
+
+        const CompiledExpression* e = cache.get(s);
+        if (e == nullptr)
+            e = &cache.put(s, compile(s));
+        return tryEvaluate(*e, nullptr);
+    }
+
+    // the message calculate() reports for result, an error found in the expression s
+    static std::string errorMessage(const CalcResult& result, const std::string& s)
+    {
+        size_t position = std::min<size_t>(result.position, s.length());
+        size_t length = std::min<size_t>(result.length, s.length() - position);
+        return describe(result.error, s.data() + position, length);
+    }
+
+    // translates an infix expression into bytecode; operands are converted to doubles here, once
+    // the bytecode is run through optimize() unless optimized is false
+    // nothing is reported: an expression that cannot be compiled is not valid, and its status tells why
+    CompiledExpression compile(const std::string& s, bool optimized = true)
+    {
+        infixTokens.resize(0);
+        postfixTokens.resize(0);
+
+        CalcResult skipped;
+        tokenize(s, infixTokens, skipped);
+        infixToPostfix(infixTokens, postfixTokens);
+        CompiledExpression e = assemble(postfixTokens);
+        if (e.valid)
+            e.status = skipped;
+        return optimized ? optimize(e) : e;
+    }
+
+    // rewrites compiled bytecode into an equivalent program that runs fewer instructions:
+    //   constant subexpressions are folded, except divisions by zero, which must still be reported
+    //   x * 1, 1 * x, x / 1, x + (-0), (-0) + x, x - 0 and -(-x) become x
+    //   repeated subexpressions are computed once, kept in a temporary and reused
+    // the result is bit-for-bit the same as the original's; x + 0 is kept, as it turns a -0 into +0
+    // assumeFinite also rewrites x * 0 and 0 * x to 0, which is only right when x is finite and
+    // does not divide by zero, and gives +0 where a negative x would give -0,
+    // so it is left to callers who know their inputs
+    // numbers and their negations keep their text for evaluateAs(); constants folded from several numbers
+    // exist only as doubles, and evaluateAs() reports them as FOLDED_CONSTANT for any other type
+    CompiledExpression optimize(const CompiledExpression& e, bool assumeFinite = false) const
+    {
+        if (!e.valid)
+            return e;
+
+        ExpressionGraph graph(e.code.size(), assumeFinite, e.literals);
+        std::vector<int> stack;
+        for (const Instruction& ins : e.code){
+            int rhs;
+            graph.position = ins.position;
+            switch (ins.op){
+                case OpCode::PUSH:
+                    stack.push_back(graph.node(OpCode::PUSH, ins.value, ins.slot, -1, -1));
+                    break;
+                case OpCode::LOAD:
+                    stack.push_back(graph.node(OpCode::LOAD, 0.0, ins.slot, -1, -1));
+                    break;
+                case OpCode::NEG:
+                    stack.back() = graph.negate(stack.back());
+                    break;
+                case OpCode::CALL1:
+                    stack.back() = graph.unary(ins.slot, stack.back());
+                    break;
+                case OpCode::SAVE:
+                case OpCode::TEMP:
+                    // already optimized; there is nothing more to gain
+                    return e;
+                default:
+                    rhs = stack.back();
+                    stack.pop_back();
+                    stack.back() = graph.binary(ins.op, ins.slot, stack.back(), rhs);
+                    break;
+            }
+        }
+
+        CompiledExpression optimized;
+        optimized.variables = e.variables;
+        optimized.status = e.status;
+        graph.emit(stack.back(), optimized);
+        optimized.literals.swap(graph.literals);
+        optimized.valid = true;
+        return optimized;
+    }
+
+    // runs a compiled expression that has no variables
+    double evaluate(const CompiledExpression& e) const
+    {
+        return evaluate(e, nullptr);
+    }
+
+    // runs a compiled expression; bindings[i] is the value of the variable in slot i (see CompiledExpression::slot)
+    // the names were resolved to slots by compile(), so evaluation never looks a name up
+    // dispatch picks the interpreter; THREADED falls back to SWITCH where computed goto is not available
+    // reports an unbound variable or a division by zero to std::cerr and returns 0.0; an expression that
+    // could not be compiled gives 0.0 too, its error being in e.status
+    double evaluate(const CompiledExpression& e, const double* bindings, Dispatch dispatch = Dispatch::THREADED) const
+    {
+        CalcResult result = tryEvaluate(e, bindings, dispatch);
+        if (result.error == CalcError::UNBOUND_VARIABLE)
+            std::cerr << describe(result.error, e.variables[0].data(), e.variables[0].length());
+        else if (result.error == CalcError::DIVISION_BY_ZERO)
+            std::cerr << describe(result.error, nullptr, 0);
+        return result.value;
+    }
+
+    // runs a compiled expression like evaluate() does, but returns what went wrong instead of reporting it
+    // an error of compile() comes back as it is in e.status
+    CalcResult tryEvaluate(const CompiledExpression& e, const double* bindings, Dispatch dispatch = Dispatch::THREADED) const
+    {
+        if (!e.valid)
+            return e.status;
+
+        if (bindings == nullptr && !e.variables.empty())
+            return unboundVariable(e);
+
+        double local[LOCAL_STACK];
+        std::vector<double> heap;
+        double* stack = local;
+        if (e.maxDepth > LOCAL_STACK){
+            heap.resize(e.maxDepth);
+            stack = heap.data();
+        }
+
+        double localTemporaries[LOCAL_STACK];
+        std::vector<double> heapTemporaries;
+        double* temporaries = localTemporaries;
+        if (e.temporaries > LOCAL_STACK){
+            heapTemporaries.resize(e.temporaries);
+            temporaries = heapTemporaries.data();
+        }
+
+        // a skipped character or number is still reported along with the value
+        CalcResult result = e.status;
+        const Instruction* failed;
+#ifdef __GNUC__
+        if (dispatch == Dispatch::THREADED)
+            failed = runThreaded(e.code.begin(), e.code.size(), bindings, stack, temporaries, result.value);
+        else
+#endif
+            failed = runSwitch(e.code.begin(), e.code.size(), bindings, stack, temporaries, result.value);
+
+        // zero division
+        if (failed != nullptr)
+            return failure(CalcError::DIVISION_BY_ZERO, failed->position, 1);
+        return result;
+    }
+
+    // calculates the value of an infix expression in another numeric type than double, e.g. MyBigDecimal
+    // numbers are read from their text, and nothing is computed in double unless an operator has to be (see evaluateAs)
+    template <typename Number>
+    Number calculateAs(const std::string& s)
+    {
+        Number value;
+        CalcResult result = tryEvaluateAs<Number>(compile(s, false), nullptr, value);
+        if (!result.ok())
+            std::cerr << errorMessage(result, s);
+        return value;
+    }
+
+    // converts the numbers of a compiled expression to Number once, for evaluateAs() to run it many times
+    // a number Number cannot hold gives OUT_OF_RANGE, and a constant optimize() folded in double gives
+    // FOLDED_CONSTANT unless Number is double; the error is returned by every evaluation
+    template <typename Number>
+    PreparedExpression<Number> prepareAs(const CompiledExpression& e) const
+    {
+        typedef NumberTraits<Number> Traits;
+        PreparedExpression<Number> p;
+        p.expression = e;
+        p.expression.literals.clear();
+        if (!e.valid)
+            return p;
+
+        for (Instruction& ins : p.expression.code){
+            if (ins.op != OpCode::PUSH)
+                continue;
+
+            Number value;
+            if (ins.slot < e.literals.size()){
+                const char* text = e.literals.data() + ins.slot;
+                if (!Traits::literal(text, std::strchr(text, ' ') - text, ins.value, value) && p.conversion.ok())
+                    p.conversion = failure(CalcError::OUT_OF_RANGE, ins.position, 0);
+            }
+            else if (!Traits::folded(ins.value, value) && p.conversion.ok())
+                p.conversion = failure(CalcError::FOLDED_CONSTANT, ins.position, 0);
+
+            ins.slot = p.constants.size();
+            p.constants.push_back(value);
+        }
+        return p;
+    }
+
+    // runs a compiled expression in another numeric type than double; bindings[i] is the value of variable slot i
+    // + - * / unary minus, comparisons, min, max and abs are computed in Number; %, ^ and sqrt have no exact
+    // counterpart, so they go through double and back
+    // numbers are read from their text in e.literals; a constant that optimize() folded in double has none, and
+    // gives FOLDED_CONSTANT unless Number is double, so compile with optimized false an expression with constant parts
+    // reports an unbound variable, a division by zero or a result that Number cannot hold, and returns zero
+    // each call converts the numbers of e again; prepareAs() does it once for an expression run many times
+    template <typename Number>
+    Number evaluateAs(const CompiledExpression& e, const Number* bindings) const
+    {
+        return evaluateAs<Number>(prepareAs<Number>(e), bindings);
+    }
+
+    // runs an expression prepared by prepareAs() like evaluateAs() of its compiled expression
+    template <typename Number>
+    Number evaluateAs(const PreparedExpression<Number>& p, const Number* bindings) const
+    {
+        const CompiledExpression& e = p.expression;
+        Number value;
+        CalcResult result = tryEvaluateAs<Number>(p, bindings, value);
+        if (result.error == CalcError::UNBOUND_VARIABLE)
+            std::cerr << describe(result.error, e.variables[0].data(), e.variables[0].length());
+        else if (result.error == CalcError::DIVISION_BY_ZERO || result.error == CalcError::OUT_OF_RANGE ||
+                 result.error == CalcError::FOLDED_CONSTANT)
+            std::cerr << describe(result.error, nullptr, 0);
+        return value;
+    }
+
+    // runs a compiled expression like evaluateAs() does, into value, but returns what went wrong instead of
+    // reporting it; value is left zero by every error but a skipped character or number
+    template <typename Number>
+    CalcResult tryEvaluateAs(const CompiledExpression& e, const Number* bindings, Number& value) const
+    {
+        return tryEvaluateAs<Number>(prepareAs<Number>(e), bindings, value);
+    }
+
+    // runs an expression prepared by prepareAs() like tryEvaluateAs() of its compiled expression
+    template <typename Number>
+    CalcResult tryEvaluateAs(const PreparedExpression<Number>& p, const Number* bindings, Number& value) const
+    {
+        typedef NumberTraits<Number> Traits;
+        const CompiledExpression& e = p.expression;
+        value = Number();
+        if (!e.valid)
+            return e.status;
+        if (!p.conversion.ok())
+            return p.conversion;
+
+        if (bindings == nullptr && !e.variables.empty())
+            return unboundVariable(e);
+
+        ScratchSpace<Number> scratch(e.maxDepth + e.temporaries);
+        Number* stack = scratch.data;
+        Number* temporaries = scratch.data + e.maxDepth;
+        const OperatorInfo* table = operatorTable();
+        size_t top = 0;
+        bool fits = true;
+
+        for (const Instruction& ins : e.code){
+            switch (ins.op){
+                case OpCode::PUSH:
+                    stack[top++] = p.constants[ins.slot];
+                    break;
+                case OpCode::LOAD:
+                    stack[top++] = bindings[ins.slot];
+                    break;
+                case OpCode::NEG:
+                    fits = Traits::negate(stack[top - 1]);
+                    break;
+                case OpCode::SAVE:
+                    temporaries[ins.slot] = stack[top - 1];
+                    break;
+                case OpCode::TEMP:
+                    stack[top++] = temporaries[ins.slot];
+                    break;
+                case OpCode::ADD:
+                    top--;
+                    fits = Traits::add(stack[top - 1], stack[top]);
+                    break;
+                case OpCode::SUB:
+                    top--;
+                    fits = Traits::subtract(stack[top - 1], stack[top]);
+                    break;
+                case OpCode::MUL:
+                    top--;
+                    fits = Traits::multiply(stack[top - 1], stack[top]);
+                    break;
+                case OpCode::DIV:
+                    top--;
+                    // zero division
+                    if (Traits::isZero(stack[top]))
+                        return failure(CalcError::DIVISION_BY_ZERO, ins.position, 1);
+                    fits = Traits::divide(stack[top - 1], stack[top]);
+                    break;
+                case OpCode::CALL1:
+                    if (table[ins.slot].unary == absKernel){
+                        Number zero = Number();
+                        if (Traits::compare(stack[top - 1], zero) < 0)
+                            fits = Traits::negate(stack[top - 1]);
+                    }
+                    else
+                        fits = Traits::fromDouble(table[ins.slot].unary(Traits::toDouble(stack[top - 1])), stack[top - 1]);
+                    break;
+                case OpCode::CALL2:{
+                    top--;
+                    Number& a = stack[top - 1];
+                    const Number& b = stack[top];
+                    double (*kernel)(double, double) = table[ins.slot].binary;
+                    // the kernels that only compare their operands
+                    if (kernel == minKernel || kernel == maxKernel){
+                        int order = Traits::compare(a, b);
+                        if ((kernel == minKernel) == (order > 0))
+                            a = b;
+                    }
+                    else if (kernel == lessKernel || kernel == lessEqualKernel || kernel == greaterKernel ||
+                             kernel == greaterEqualKernel || kernel == equalKernel || kernel == notEqualKernel){
+                        // the kernel itself, given the order of the operands as -1, 0 or 1
+                        double truth = kernel(Traits::compare(a, b), 0.0);
+                        fits = Traits::fromDouble(truth, a);
+                    }
+                    else
+                        fits = Traits::fromDouble(kernel(Traits::toDouble(a), Traits::toDouble(b)), a);
+                    break;
+                }
+            }
+
+            if (!fits)
+                return failure(CalcError::OUT_OF_RANGE, ins.position, 0);
+        }
+
+        value = stack[0];
+        return e.status;
+    }
+
+    // runs a compiled expression once per row: out[r] = e evaluated with variable slot i bound to columns[i][r]
+    // rows are processed in blocks of BATCH_BLOCK, so every instruction is one loop over a whole block
+    // of operands (AVX2 lanes when compiled with AVX2 enabled) rather than one dispatch per row
+    // rows that divide by zero get 0.0, like evaluate(); the error is reported once per call
+    void evaluateBatch(const CompiledExpression& e, const double* const* columns, double* out, size_t rows) const
+    {
+        if (!e.valid || (columns == nullptr && !e.variables.empty())){
+            if (e.valid)
+                std::cerr << describe(CalcError::UNBOUND_VARIABLE, e.variables[0].data(), e.variables[0].length());
+            std::fill(out, out + rows, 0.0);
+            return;
+        }
+
+        // one block of operands per stack level, stored level after level
+        std::vector<double> stack(std::max<size_t>(e.maxDepth, 1) * BATCH_BLOCK);
+        std::vector<double> temporaries(e.temporaries * BATCH_BLOCK);
+        unsigned char failed[BATCH_BLOCK];
+        bool anyFailed = false;
+        const OperatorInfo* table = operatorTable();
+
+        for (size_t first = 0; first < rows; first += BATCH_BLOCK){
+            size_t n = rows - first < BATCH_BLOCK ? rows - first : BATCH_BLOCK;
+            std::fill(failed, failed + n, 0);
+
+            double* top = stack.data();     // the block just above the top of the stack
+            for (const Instruction& ins : e.code){
+                switch (ins.op){
+                    case OpCode::PUSH:
+                        std::fill(top, top + n, ins.value);
+                        top += BATCH_BLOCK;
+                        break;
+                    case OpCode::LOAD:
+                        std::copy(columns[ins.slot] + first, columns[ins.slot] + first + n, top);
+                        top += BATCH_BLOCK;
+                        break;
+                    case OpCode::NEG:{
+                        double* x = top - BATCH_BLOCK;
+                        for (size_t i = 0; i < n; i++){
+                            x[i] = -x[i];
+                        }
+                        break;
+                    }
+                    case OpCode::SAVE:
+                        std::copy(top - BATCH_BLOCK, top - BATCH_BLOCK + n, &temporaries[ins.slot * BATCH_BLOCK]);
+                        break;
+                    case OpCode::TEMP:
+                        std::copy(&temporaries[ins.slot * BATCH_BLOCK], &temporaries[ins.slot * BATCH_BLOCK] + n, top);
+                        top += BATCH_BLOCK;
+                        break;
+                    case OpCode::CALL1:{
+                        double* x = top - BATCH_BLOCK;
+                        double (*kernel)(double) = table[ins.slot].unary;
+                        for (size_t i = 0; i < n; i++){
+                            x[i] = kernel(x[i]);
+                        }
+                        break;
+                    }
+                    case OpCode::CALL2:{
+                        top -= BATCH_BLOCK;
+                        double* x = top - BATCH_BLOCK;
+                        double (*kernel)(double, double) = table[ins.slot].binary;
+                        for (size_t i = 0; i < n; i++){
+                            x[i] = kernel(x[i], top[i]);
+                        }
+                        break;
+                    }
+                    default:
+                        top -= BATCH_BLOCK;
+                        batchBinary(ins.op, top - BATCH_BLOCK, top, n, failed);
+                        break;
+                }
+            }
+
+            for (size_t i = 0; i < n; i++){
+                out[first + i] = failed[i] ? 0.0 : stack[i];
+                anyFailed = anyFailed || failed[i];
+            }
+        }
+
+        if (anyFailed)
+            std::cerr << describe(CalcError::DIVISION_BY_ZERO, nullptr, 0);
+    }
+
+    // calculates the value of an infix expression read from in, in a single pass
+    // tokenizing, shunting-yard and evaluation are interleaved: every operator is applied to a stack of
+    // values as soon as the parser would have emitted it, so memory grows with the nesting depth of the
+    // expression, not with its length, and no token or bytecode array is ever built
+    // gives the same result and reports the same errors as calculate(), in the same order;
+    // variables are parsed but there is nothing to bind them to
+    // reads one line per call, like std::getline(): the line ending is consumed, the end of the stream
+    // sets eofbit on in, and a call with no line left to read also sets failbit and reports nothing,
+    // so that "while (in) calculateStream(in)" calculates a file line by line
+    double calculateStream(std::istream& in)
+    {
+        if (!in || in.rdbuf()->sgetc() == EOF){
+            in.setstate(std::ios::eofbit | std::ios::failbit);
+            return 0.0;
+        }
+
+        StreamSource source{in.rdbuf(), 0};
+        MyStack<double> values;
+        MyStack<Token> operators;
+        const OperatorInfo* table = operatorTable();
+        std::string text;               // the characters of the number or name being read
+        std::string error;              // the first error that stops evaluation; reported at the end
+        std::string skipped;            // the first character or number skipped, if nothing stops evaluation
+        std::string unbound;            // the first variable seen
+        bool divisionByZero = false;
+
+        auto skip = [&skipped](CalcError kind, const char* characters, size_t length, unsigned){
+            if (skipped.empty())
+                skipped = describe(kind, characters, length);
+        };
+
+        // runs a token the way evaluate() would run its instruction
+        auto apply = [&](const Token& token){
+            if (!error.empty())
+                return;
+
+            switch (token.kind){
+                case TokenKind::NUMBER:
+                    values.push(token.value);
+                    break;
+                case TokenKind::VARIABLE:
+                    // its value is unknown, so only its name is kept for the error message
+                    if (unbound.empty())
+                        unbound.assign(token.name, token.length);
+                    values.push(0.0);
+                    break;
+                case TokenKind::OPERATOR:
+                case TokenKind::FUNCTION:{
+                    const OperatorInfo& info = table[token.op];
+                    if (values.size() < static_cast<size_t>(info.arity)){
+                        error = describe(CalcError::MISSING_OPERAND, info.symbol, std::strlen(info.symbol));
+                        break;
+                    }
+                    if (info.arity == 1){
+                        values.top() = info.unary(values.top());
+                        break;
+                    }
+
+                    double rhs = values.pop_and_get();
+                    // calculate() only reports this if the whole expression compiles
+                    if (info.op == OpCode::DIV)
+                        divisionByZero = divisionByZero || rhs == 0;
+                    values.top() = info.binary(values.top(), rhs);
+                    break;
+                }
+                default:
+                    // an open parenthesis that was never closed
+                    error = describe(values.size() < 2 ? CalcError::MISSING_OPERAND : CalcError::UNCLOSED_PARENTHESIS, "(", 1);
+                    break;
+            }
+        };
+
+        Token token;
+        bool operandExpected = true;
+        while (readToken(source, operandExpected, token, text, skip)){
+            shunt(token, operators, apply);
+            operandExpected = expectsOperand(token);
+        }
+        while (!operators.empty()){
+            apply(operators.pop_and_get());
+        }
+        if (!source.endLine())
+            in.setstate(std::ios::eofbit);
+
+        if (!error.empty()){
+            std::cerr << error;
+            return 0.0;
+        }
+        if (values.size() != 1){
+            std::cerr << describe(CalcError::INVALID_EXPRESSION, nullptr, 0);
+            return 0.0;
+        }
+        if (!unbound.empty()){
+            std::cerr << describe(CalcError::UNBOUND_VARIABLE, unbound.data(), unbound.length());
+            return 0.0;
+        }
+        if (divisionByZero){
+            std::cerr << describe(CalcError::DIVISION_BY_ZERO, nullptr, 0);
+            return 0.0;
+        }
+        std::cerr << skipped;
+        return values.top();
     }
 
   private:
 
-    // returns operator precedance; the smaller the number the higher precedence
-    // returns -1 if the operator is invalid
-    // does not consider parenthesis
-    int operatorPrec(const char c) const
+    static CalcResult failure(CalcError error, unsigned position, unsigned length)
     {
-        switch(c)
-        {
-            case '*':
-                return 2;
-            case '/':
-                return 2;
-            case '+':
-                return 3;
-            case '-':
-                return 3;
-            default:
-                return -1;
+        CalcResult result;
+        result.error = error;
+        result.position = position;
+        result.length = length;
+        return result;
+    }
+
+    // the error of running e with no bindings, which points at the first use of its first variable
+    static CalcResult unboundVariable(const CompiledExpression& e)
+    {
+        unsigned position = 0;
+        for (const Instruction& ins : e.code){
+            if (ins.op == OpCode::LOAD && ins.slot == 0){
+                position = ins.position;
+                break;
+            }
+        }
+        return failure(CalcError::UNBOUND_VARIABLE, position, static_cast<unsigned>(e.variables[0].length()));
+    }
+
+    // the message for an error; text is the offending token, where the message names it
+    static std::string describe(CalcError error, const char* text, size_t length)
+    {
+        std::string token(text == nullptr ? "" : std::string(text, length));
+        switch (error){
+            case CalcError::NONE:
+                return "";
+            case CalcError::INVALID_CHARACTER:
+                return "Error: Invalid character '" + token + "' in input.\n";
+            case CalcError::INVALID_NUMBER:
+                return "Error: Invalid number '" + token + "' in input.\n";
+            case CalcError::MISSING_OPERAND:
+                return "Error: Not enough operands for operator " + token + ".\n";
+            case CalcError::UNCLOSED_PARENTHESIS:
+                return "Error: Unknown operator '('.\n";
+            case CalcError::INVALID_EXPRESSION:
+                return "Error: Invalid postfix expression.\n";
+            case CalcError::UNBOUND_VARIABLE:
+                return "Error: Unbound variable '" + token + "'.\n";
+            case CalcError::DIVISION_BY_ZERO:
+                return "Error: Division by zero.\n";
+            case CalcError::OUT_OF_RANGE:
+                return "Error: Result out of range.\n";
+            case CalcError::CIRCULAR_REFERENCE:
+                return "Error: Circular reference.\n";
+            case CalcError::FOLDED_CONSTANT:
+                return "Error: Constant computed in double; compile without optimizing for an exact result.\n";
         }
+        return "";
     }
 
-    // checks if a character corresponds to a valid parenthesis
-    bool isValidParenthesis(const char c) const
+    // the operands and temporaries of tryEvaluateAs(): like those of evaluate() they are on the C++ stack
+    // unless the program needs more than LOCAL_STACK, but only as many Numbers as it uses are constructed,
+    // as a Number such as MyBigDecimal costs more than a double to make and destroy
+    template <typename Number>
+    class ScratchSpace
     {
-        switch(c)
+      public:
+        explicit ScratchSpace(size_t size) :
+            constructed{size <= LOCAL_STACK ? size : 0},
+            heap(size <= LOCAL_STACK ? 0 : size)
         {
-            case '(':
-                return true;
-            case ')':
+            Number* local = reinterpret_cast<Number*>(storage);
+            for (size_t i = 0; i < constructed; i++)
+                new (local + i) Number();
+            data = constructed > 0 ? local : heap.data();
+        }
+
+        ~ScratchSpace()
+        {
+            for (size_t i = 0; i < constructed; i++)
+                data[i].~Number();
+        }
+
+        Number* data;
+
+      private:
+        typename std::aligned_storage<sizeof(Number), alignof(Number)>::type storage[LOCAL_STACK];
+        size_t constructed;         // how many Numbers of storage are in use
+        std::vector<Number> heap;   // the Numbers when there are more than LOCAL_STACK
+
+        ScratchSpace(const ScratchSpace&);
+        ScratchSpace& operator=(const ScratchSpace&);
+    };
+
+    // the expression graph optimize() rewrites bytecode through
+    // nodes are hash-consed, so structurally identical subexpressions are one shared node
+    struct ExpressionGraph
+    {
+        struct Node
+        {
+            OpCode op;
+            unsigned position;  // the source position of the instruction that made it, for error reports
+            double value;       // the constant of a PUSH node
+            size_t slot;        // the variable of a LOAD node
+            int lhs, rhs;       // operand nodes; -1 where the operator has fewer operands
+        };
+
+        std::vector<Node> nodes;        // every node comes after its operands
+        std::vector<int> index;         // open-addressed hash table of node numbers; -1 marks a free entry
+        bool assumeFinite;
+        unsigned position;              // the source position given to the nodes made next
+        std::string literals;           // the text of the numbers of the program, which PUSH nodes keep,
+                                        // and of the negated ones negate() makes
+
+        // a graph for a program of `instructions` instructions, which never makes more nodes than that
+        ExpressionGraph(size_t instructions, bool finite, const std::string& text) :
+            assumeFinite{finite},
+            position{0},
+            literals(text)
+        {
+            size_t capacity = 16;
+            while (capacity < 2 * instructions)
+                capacity *= 2;
+            nodes.reserve(instructions);
+            index.assign(capacity, -1);
+        }
+
+        // checks if two PUSH slots give the same number to an exact evaluation: both without text,
+        // or with the same text at either place in literals
+        bool sameLiteral(size_t a, size_t b) const
+        {
+            if (a == b)
                 return true;
-            default:
+            if (a >= literals.size() || b >= literals.size())
                 return false;
+
+            const char* p = literals.data();
+            for (; p[a] == p[b]; a++, b++){
+                if (p[a] == ' ')
+                    return true;
+            }
+            return false;
+        }
+
+        // returns the node for op applied to the given operands, creating it if it does not exist yet
+        // a PUSH node keeps the text of its number in slot, and the same number written the same way is one node
+        int node(OpCode op, double value, size_t slot, int lhs, int rhs)
+        {
+            // constants are told apart by their bits, so that 0 and -0 stay different nodes
+            unsigned long long bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            unsigned long long h = bits ^ (static_cast<unsigned long long>(op) << 56) ^ (op == OpCode::PUSH ? 0 : slot);
+            h = (h ^ static_cast<unsigned>(lhs)) * 0x9E3779B97F4A7C15ull;
+            h = (h ^ static_cast<unsigned>(rhs)) * 0x9E3779B97F4A7C15ull;
+
+            size_t mask = index.size() - 1;
+            for (size_t i = (h >> 32) & mask; ; i = (i + 1) & mask){
+                if (index[i] < 0){
+                    nodes.push_back(Node{op, position, value, slot, lhs, rhs});
+                    index[i] = static_cast<int>(nodes.size() - 1);
+                    return index[i];
+                }
+
+                const Node& n = nodes[index[i]];
+                bool sameSlot = op == OpCode::PUSH ? sameLiteral(n.slot, slot) : n.slot == slot;
+                if (n.op == op && sameSlot && n.lhs == lhs && n.rhs == rhs && std::memcmp(&n.value, &value, sizeof(value)) == 0)
+                    return index[i];
+            }
+        }
+
+        // a constant folded in double, which has no text
+        int constant(double value)
+        {
+            return node(OpCode::PUSH, value, NO_LITERAL, -1, -1);
+        }
+
+        // checks if node n is the constant value (either zero, for value 0)
+        bool isConstant(int n, double value) const
+        {
+            return nodes[n].op == OpCode::PUSH && nodes[n].value == value;
         }
-    }
+
+        // negation is exact in every numeric type, so a negated number keeps its text, with a minus added or removed
+        int negate(int a)
+        {
+            if (nodes[a].op == OpCode::PUSH && nodes[a].slot < literals.size()){
+                size_t slot = nodes[a].slot;
+                if (literals[slot] == '-')
+                    return node(OpCode::PUSH, -nodes[a].value, slot + 1, -1, -1);
+
+                size_t negated = literals.size();
+                literals += '-';
+                literals.append(literals, slot, literals.find(' ', slot) + 1 - slot);
+                return node(OpCode::PUSH, -nodes[a].value, negated, -1, -1);
+            }
+            if (nodes[a].op == OpCode::PUSH)
+                return constant(-nodes[a].value);
+            if (nodes[a].op == OpCode::NEG)
+                return nodes[a].lhs;
+            return node(OpCode::NEG, 0.0, OPERATOR_NEGATE, a, -1);
+        }
+
+        // the node for the one-operand operator in operatorTable() entry op
+        int unary(size_t op, int a)
+        {
+            if (nodes[a].op == OpCode::PUSH)
+                return constant(operatorTable()[op].unary(nodes[a].value));
+            return node(OpCode::CALL1, 0.0, op, a, -1);
+        }
+
+        // the node for the two-operand operator in operatorTable() entry op, run by opcode code
+        int binary(OpCode code, size_t op, int a, int b)
+        {
+            bool constants = nodes[a].op == OpCode::PUSH && nodes[b].op == OpCode::PUSH;
+            switch (code){
+                case OpCode::ADD:
+                    if (constants)
+                        return constant(nodes[a].value + nodes[b].value);
+                    // -0 + +0 is +0, so only adding -0 leaves every x as it is
+                    if (isConstant(b, 0) && std::signbit(nodes[b].value))
+                        return a;
+                    if (isConstant(a, 0) && std::signbit(nodes[a].value))
+                        return b;
+                    break;
+                case OpCode::SUB:
+                    if (constants)
+                        return constant(nodes[a].value - nodes[b].value);
+                    if (isConstant(b, 0) && !std::signbit(nodes[b].value))
+                        return a;
+                    break;
+                case OpCode::MUL:
+                    if (constants)
+                        return constant(nodes[a].value * nodes[b].value);
+                    if (isConstant(b, 1))
+                        return a;
+                    if (isConstant(a, 1))
+                        return b;
+                    if (assumeFinite && (isConstant(a, 0) || isConstant(b, 0)))
+                        return constant(0.0);
+                    break;
+                case OpCode::DIV:
+                    // a division by zero is left for the evaluator to report
+                    if (constants && nodes[b].value != 0)
+                        return constant(nodes[a].value / nodes[b].value);
+                    if (isConstant(b, 1))
+                        return a;
+                    break;
+                default:
+                    if (constants)
+                        return constant(operatorTable()[op].binary(nodes[a].value, nodes[b].value));
+                    break;
+            }
+            return node(code, 0.0, op, a, b);
+        }
+
+        // writes the bytecode computing node root into e
+        // an operator node used more than once is computed the first time and saved into a temporary
+        void emit(int root, CompiledExpression& e) const
+        {
+            // count the uses of every node reachable from root; operands always come before their users
+            std::vector<int> uses(nodes.size(), 0);
+            uses[root] = 1;
+            for (int n = root; n >= 0; n--){
+                if (uses[n] == 0)
+                    continue;
+                if (nodes[n].lhs >= 0)
+                    uses[nodes[n].lhs]++;
+                if (nodes[n].rhs >= 0)
+                    uses[nodes[n].rhs]++;
+            }
+
+            std::vector<int> temporary(nodes.size(), -1);     // the temporary of a shared node, once computed
+            std::vector<std::pair<int, bool> > work;            // nodes still to emit; true once operands are queued
+            work.push_back(std::make_pair(root, false));
+            size_t depth = 0;
+
+            // iterative, as a long chain of operators nests as deep as it is long
+            while (!work.empty()){
+                int n = work.back().first;
+                bool expanded = work.back().second;
+                work.pop_back();
+                const Node& current = nodes[n];
+
+                if (temporary[n] >= 0){
+                    e.code.push_back(Instruction{OpCode::TEMP, current.position, 0.0, static_cast<size_t>(temporary[n])});
+                    depth++;
+                }
+                else if (!expanded && current.lhs >= 0){
+                    work.push_back(std::make_pair(n, true));
+                    if (current.rhs >= 0)
+                        work.push_back(std::make_pair(current.rhs, false));
+                    work.push_back(std::make_pair(current.lhs, false));
+                }
+                else{
+                    e.code.push_back(Instruction{current.op, current.position, current.value, current.slot});
+                    if (current.op == OpCode::PUSH || current.op == OpCode::LOAD)
+                        depth++;
+                    else if (current.rhs >= 0)
+                        depth--;
+
+                    // leaves are as cheap to push again as a temporary
+                    if (uses[n] > 1 && current.lhs >= 0){
+                        temporary[n] = static_cast<int>(e.temporaries++);
+                        e.code.push_back(Instruction{OpCode::SAVE, current.position, 0.0, static_cast<size_t>(temporary[n])});
+                    }
+                }
+                e.maxDepth = std::max(e.maxDepth, depth);
+            }
+        }
+    };
+
+
+    MyLRUCache<std::string, CompiledExpression> cache;  // compiled form of recently calculated expressions
+
+    // scratch space of compile(); kept between calls so that tokens cost no allocation once it has grown
+    MyVector<Token> infixTokens;
+    MyVector<Token> postfixTokens;
+    MyStack<Token> operatorStack;
 
     // checks if a character corresponds to a valid digit
     bool isDigit(const char c) const
@@ -75,184 +1051,528 @@ class MyInfixCalculator{
         return false;
     }
 
-    // computes binary operation given the two operands and the operator in their string form
-    double computeBinaryOperation(const std::string& ornd1, const std::string& ornd2, const std::string& opt) const
+    // checks if a character may start a variable name
+    bool isIdentifierStart(const char c) const
     {
-        double o1 = std::stod(ornd1);
-        double o2 = std::stod(ornd2);
-        switch(opt[0])
-        {
-            case '+':
-                return o1 + o2;
-            case '-':
-                return o1 - o2;
-            case '*':
-                return o1 * o2;
-            case '/':
-                return o1 / o2;
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    // checks if a character may continue a variable name
+    bool isIdentifierChar(const char c) const
+    {
+        return isIdentifierStart(c) || isDigit(c);
+    }
+
+    // checks if a minus sign right after token is a sign rather than a subtraction
+    static bool expectsOperand(const Token& token)
+    {
+        return token.kind == TokenKind::OPERATOR || token.kind == TokenKind::FUNCTION
+            || token.kind == TokenKind::LEFT_PARENTHESIS || token.kind == TokenKind::COMMA;
+    }
+
+    // a[i] = a[i] op b[i] for i < n; marks failed[i] where a division has a zero divisor
+    static void batchBinary(OpCode op, double* a, const double* b, size_t n, unsigned char* failed)
+    {
+        size_t i = 0;
+#ifdef __AVX2__
+        for (; i + 4 <= n; i += 4){
+            __m256d x = _mm256_loadu_pd(a + i);
+            __m256d y = _mm256_loadu_pd(b + i);
+            switch (op){
+                case OpCode::ADD:
+                    x = _mm256_add_pd(x, y);
+                    break;
+                case OpCode::SUB:
+                    x = _mm256_sub_pd(x, y);
+                    break;
+                case OpCode::MUL:
+                    x = _mm256_mul_pd(x, y);
+                    break;
+                default:{
+                    int zero = _mm256_movemask_pd(_mm256_cmp_pd(y, _mm256_setzero_pd(), _CMP_EQ_OQ));
+                    for (int k = 0; zero != 0; k++, zero >>= 1){
+                        failed[i + k] |= zero & 1;
+                    }
+                    x = _mm256_div_pd(x, y);
+                    break;
+                }
+            }
+            _mm256_storeu_pd(a + i, x);
+        }
+#endif
+        switch (op){
+            case OpCode::ADD:
+                for (; i < n; i++)
+                    a[i] += b[i];
+                break;
+            case OpCode::SUB:
+                for (; i < n; i++)
+                    a[i] -= b[i];
+                break;
+            case OpCode::MUL:
+                for (; i < n; i++)
+                    a[i] *= b[i];
+                break;
             default:
-                std::cerr << "Error: unrecognized operator: " << opt << std::endl;
-                return 0.0;
+                for (; i < n; i++){
+                    failed[i] |= b[i] == 0;
+                    a[i] /= b[i];
+                }
+                break;
         }
     }
 
+    // the interpreters behind evaluate(); both run code[0, n) and leave the value in result
+    // they return the division that failed, leaving result unset, as soon as one divides by zero; nullptr otherwise
+    // the top of the operand stack lives in a local (a register, in practice) rather than in stack,
+    // so an operator reads one operand from memory instead of two and writes none; stack holds the rest,
+    // plus one meaningless value spilled by the first push, so it needs room for maxDepth values
+    static const Instruction* runSwitch(const Instruction* code, size_t n, const double* bindings, double* stack, double* temporaries, double& result)
+    {
+        const OperatorInfo* table = operatorTable();
+        double top = 0.0;
+        double* below = stack;      // one past the value under top
 
-    // tokenizes an infix string s into a set of tokens (operands or operators)
-    void tokenize(const std::string& s, MyVector<std::string>& tokens)
+        for (const Instruction* ins = code; ins != code + n; ins++){
+            switch (ins->op){
+                case OpCode::PUSH:
+                    *below++ = top;
+                    top = ins->value;
+                    break;
+                case OpCode::LOAD:
+                    *below++ = top;
+                    top = bindings[ins->slot];
+                    break;
+                case OpCode::NEG:
+                    top = -top;
+                    break;
+                case OpCode::SAVE:
+                    temporaries[ins->slot] = top;
+                    break;
+                case OpCode::TEMP:
+                    *below++ = top;
+                    top = temporaries[ins->slot];
+                    break;
+                case OpCode::ADD:
+                    top = *--below + top;
+                    break;
+                case OpCode::SUB:
+                    top = *--below - top;
+                    break;
+                case OpCode::MUL:
+                    top = *--below * top;
+                    break;
+                case OpCode::DIV:
+                    if (top == 0)
+                        return ins;
+                    top = *--below / top;
+                    break;
+                case OpCode::CALL1:
+                    top = table[ins->slot].unary(top);
+                    break;
+                case OpCode::CALL2:
+                    top = table[ins->slot].binary(*--below, top);
+                    break;
+            }
+        }
+
+        result = top;
+        return nullptr;
+    }
+
+#ifdef __GNUC__
+    // the same interpreter with computed goto (a GNU extension that gcc and clang support)
+    // every handler ends in its own indirect jump, so the branch predictor learns which handler tends
+    // to follow which, instead of sharing the single jump of a switch among all of them
+    static const Instruction* runThreaded(const Instruction* code, size_t n, const double* bindings, double* stack, double* temporaries, double& result)
     {
-        size_t i = 0;
-        while (i < s.length()){
-            
+        // in the order of OpCode
+        static const void* const handlers[] = {
+            &&PUSH, &&LOAD, &&NEG, &&SAVE, &&TEMP, &&ADD, &&SUB, &&MUL, &&DIV, &&CALL1, &&CALL2
+        };
+        const OperatorInfo* table = operatorTable();
+        const Instruction* ins = code;
+        const Instruction* end = code + n;
+        double top = 0.0;
+        double* below = stack;
+
+        #define DISPATCH() \
+            if (++ins == end) goto FINISHED; \
+            goto *handlers[static_cast<int>(ins->op)]
+
+        if (ins == end)
+            goto FINISHED;
+        goto *handlers[static_cast<int>(ins->op)];
+
+        PUSH:
+            *below++ = top;
+            top = ins->value;
+            DISPATCH();
+        LOAD:
+            *below++ = top;
+            top = bindings[ins->slot];
+            DISPATCH();
+        NEG:
+            top = -top;
+            DISPATCH();
+        SAVE:
+            temporaries[ins->slot] = top;
+            DISPATCH();
+        TEMP:
+            *below++ = top;
+            top = temporaries[ins->slot];
+            DISPATCH();
+        ADD:
+            top = *--below + top;
+            DISPATCH();
+        SUB:
+            top = *--below - top;
+            DISPATCH();
+        MUL:
+            top = *--below * top;
+            DISPATCH();
+        DIV:
+            if (top == 0)
+                return ins;
+            top = *--below / top;
+            DISPATCH();
+        CALL1:
+            top = table[ins->slot].unary(top);
+            DISPATCH();
+        CALL2:
+            top = table[ins->slot].binary(*--below, top);
+            DISPATCH();
+
+        #undef DISPATCH
+
+        FINISHED:
+            result = top;
+            return nullptr;
+    }
+#endif
+
+    // parses the length characters at text the way std::stod would read them
+    // returns false if they do not start with a number
+    bool parseNumber(const char* text, size_t length, double& value) const
+    {
+        // strtod needs a terminated copy, or it could read on into the next token
+        char buffer[64];
+        std::string longNumber;
+        const char* terminated = buffer;
+        if (length < sizeof(buffer)){
+            std::memcpy(buffer, text, length);
+            buffer[length] = '\0';
+        }
+        else{
+            longNumber.assign(text, length);
+            terminated = longNumber.c_str();
+        }
+
+        char* stop;
+        value = std::strtod(terminated, &stop);
+        return stop != terminated;
+    }
+
+    // a cursor over an expression held in a string
+    struct StringSource
+    {
+        const std::string& s;
+        size_t position;
+
+        int peek() const
+        {
+            return position < s.length() ? static_cast<unsigned char>(s[position]) : EOF;
+        }
+
+        void advance()
+        {
+            position++;
+        }
+    };
+
+    // a cursor over an expression read from a stream; the expression ends with the line,
+    // at a '\n', a "\r\n" or a lone '\r'
+    struct StreamSource
+    {
+        std::streambuf* buffer;
+        size_t position;    // characters read so far
+
+        int peek() const
+        {
+            int c = buffer->sgetc();
+            return c == '\n' || c == '\r' ? EOF : c;
+        }
+
+        void advance()
+        {
+            buffer->sbumpc();
+            position++;
+        }
+
+        // consumes the line ending the expression stopped at; returns false if the stream ended instead
+        bool endLine()
+        {
+            int c = buffer->sgetc();
+            if (c == EOF)
+                return false;
+
+            buffer->sbumpc();
+            if (c == '\r' && buffer->sgetc() == '\n')
+                buffer->sbumpc();
+            return true;
+        }
+    };
+
+    // reads the next token of an expression from src into token; returns false once the expression ends
+    // operandExpected tells the sign of a number or a prefix minus from a subtraction
+    // text holds the characters of the last number or name; a VARIABLE or FUNCTION token points into it
+    // invalid characters and numbers are skipped, after passing them to skip(error, text, length, position)
+    template <typename Source, typename Skip>
+    bool readToken(Source& src, bool operandExpected, Token& token, std::string& text, Skip& skip) const
+    {
+        for (int c = src.peek(); c != EOF; c = src.peek()){
+            char ch = static_cast<char>(c);
+            text.clear();
+
+            // skip blanks between tokens
+            if (ch == ' ' || ch == '\t'){
+                src.advance();
+                continue;
+            }
+            unsigned start = static_cast<unsigned>(src.position);
+
+            // a minus sign where an operand should be: the sign of a number, or else a prefix minus
+            if (ch == '-' && operandExpected){
+                src.advance();
+                c = src.peek();
+                if (c == EOF || !(isDigit(static_cast<char>(c)) || c == '.')){
+                    token = Token{TokenKind::OPERATOR, OPERATOR_NEGATE, 0.0, nullptr, 1, start};
+                    return true;
+                }
+                text += '-';
+                ch = static_cast<char>(c);
+            }
+
             // check numbers
-            if(isDigit(s[i]) || s[i] == '.'){
-                std::string num;
-                
-                while(i < s.length() && (isDigit(s[i]) || s[i] == '.')){
-                    num += s[i];
-                    i++;
+            if (isDigit(ch) || ch == '.'){
+                while (c != EOF && (isDigit(static_cast<char>(c)) || c == '.')){
+                    text += static_cast<char>(c);
+                    src.advance();
+                    c = src.peek();
                 }
 
-                tokens.push_back(num);
+                double value;
+                if (parseNumber(text.data(), text.length(), value)){
+                    token = Token{TokenKind::NUMBER, -1, value, text.data(), text.length(), start};
+                    return true;
+                }
+                skip(CalcError::INVALID_NUMBER, text.data(), text.length(), start);
+                continue;
             }
-            // check for subtraction or negative
-            else if (s[i] == '-'){
-                //negative number
-                if (tokens.empty() || tokens.back() == "(" || (tokens.back().length() == 1 && operatorPrec(tokens.back()[0]) != -1)){
-                    std::string num = "-";
-                    i++;
-
-                    while(i < s.length() && (isDigit(s[i]) || s[i] == '.')){
-                        num += s[i];
-                        i++;
-                    }
-    
-                    tokens.push_back(num);
+
+            // check variables and functions; the names of functions are reserved
+            if (isIdentifierStart(ch)){
+                while (c != EOF && isIdentifierChar(static_cast<char>(c))){
+                    text += static_cast<char>(c);
+                    src.advance();
+                    c = src.peek();
                 }
-                // subtraction, treat like normal operator
-                else{
-                    tokens.push_back(std::string(1, s[i]));
-                    i++;
+
+                int op = findOperator(text.data(), text.length());
+                TokenKind kind = op >= 0 ? TokenKind::FUNCTION : TokenKind::VARIABLE;
+                token = Token{kind, op, 0.0, text.data(), text.length(), start};
+                return true;
+            }
+
+            src.advance();
+
+            // parenthesis and argument separators
+            if (ch == '(' || ch == ')' || ch == ','){
+                TokenKind kind = ch == '(' ? TokenKind::LEFT_PARENTHESIS : ch == ')' ? TokenKind::RIGHT_PARENTHESIS : TokenKind::COMMA;
+                token = Token{kind, -1, 0.0, nullptr, 1, start};
+                return true;
+            }
+
+            // operators; the longest one that matches
+            text += ch;
+            c = src.peek();
+            if (c != EOF){
+                text += static_cast<char>(c);
+                int op = findOperator(text.data(), 2);
+                if (op >= 0){
+                    src.advance();
+                    token = Token{TokenKind::OPERATOR, op, 0.0, nullptr, 2, start};
+                    return true;
                 }
             }
-            // operators or parenthesis
-            else if(isValidParenthesis(s[i]) || operatorPrec(s[i]) != -1){
-                tokens.push_back(std::string(1, s[i]));
-                i++;
+            int op = findOperator(text.data(), 1);
+            if (op >= 0){
+                token = Token{TokenKind::OPERATOR, op, 0.0, nullptr, 1, start};
+                return true;
             }
+
             // invalid input
-            else{
-                std::cerr << "Error: Invalid character '" << s[i] << "' in input.\n";
-                i++;
-            }
+            skip(CalcError::INVALID_CHARACTER, &ch, 1, start);
         }
+        return false;
     }
 
-    // converts a set of infix tokens to a set of postfix tokens
-    void infixToPostfix(MyVector<std::string>& infix_tokens, MyVector<std::string>& postfix_tokens)
+    // tokenizes an infix string s into a set of tokens (operands or operators)
+    // variable and number tokens point into s, so s must outlive them
+    // the first invalid character or number, which is skipped, is kept in skipped
+    void tokenize(const std::string& s, MyVector<Token>& tokens, CalcResult& skipped)
     {
-        MyStack<std::string> stack;
+        auto skip = [&skipped](CalcError error, const char*, size_t length, unsigned position){
+            if (skipped.ok())
+                skipped = failure(error, position, static_cast<unsigned>(length));
+        };
 
-        for(const std::string& token : infix_tokens){
+        StringSource source{s, 0};
+        std::string text;
+        Token token;
+        bool operandExpected = true;
+        while (readToken(source, operandExpected, token, text, skip)){
+            // text is reused for the next token, so point the name or number into s instead
+            if (token.kind == TokenKind::VARIABLE || token.kind == TokenKind::NUMBER)
+                token.name = s.data() + token.position;
+            tokens.push_back(token);
+            operandExpected = expectsOperand(token);
+        }
+    }
 
-            // digit
-            if (isDigit(token[0]) || token.length() > 1 && token[0] == '-'){
-                postfix_tokens.push_back(token);
-            }
-            // open parenthesis
-            else if(token == "("){
+    // one step of the shunting-yard algorithm: operands go straight to emit, operators wait on stack
+    // until everything that binds at least as tightly before them has been emitted
+    template <typename Emit>
+    void shunt(const Token& token, MyStack<Token>& stack, Emit& emit) const
+    {
+        const OperatorInfo* table = operatorTable();
+
+        switch (token.kind){
+            // digit or variable
+            case TokenKind::NUMBER:
+            case TokenKind::VARIABLE:
+                emit(token);
+                break;
+            // open parenthesis, or a function waiting for its arguments
+            case TokenKind::LEFT_PARENTHESIS:
+            case TokenKind::FUNCTION:
                 stack.push(token);
-            }
+                break;
+            // the end of a function argument
+            case TokenKind::COMMA:
+                while (!(stack.empty()) && stack.top().kind != TokenKind::LEFT_PARENTHESIS){
+                    emit(stack.pop_and_get());
+                }
+                break;
             // closing parenthesis
-            else if(token == ")"){
+            case TokenKind::RIGHT_PARENTHESIS:
                 // keep popping to list until open parenthesis is found
-                while(!(stack.empty()) && stack.top() != "("){
-                    postfix_tokens.push_back(stack.top());
-                    stack.pop();
+                while (!(stack.empty()) && stack.top().kind != TokenKind::LEFT_PARENTHESIS){
+                    emit(stack.pop_and_get());
                 }
 
-                // remove open parenthesis
+                // remove open parenthesis, then run the function it belongs to
                 stack.pop();
-            }
+                if (!(stack.empty()) && stack.top().kind == TokenKind::FUNCTION)
+                    emit(stack.pop_and_get());
+                break;
             // operator
-            else if(operatorPrec(token[0]) != -1){
-                // pop all operators of equal or higher precedence
-                while(!(stack.empty()) && stack.top() != "(" && operatorPrec(token[0]) >= operatorPrec(stack.top()[0])){
-                    postfix_tokens.push_back(stack.top());
-                    stack.pop();
+            case TokenKind::OPERATOR:{
+                const OperatorInfo& info = table[token.op];
+                // pop all operators of higher precedence, and of equal precedence unless right-associative
+                // a prefix operator has no left operand, so it cannot take anything from them
+                while (info.arity == 2 && !(stack.empty()) && stack.top().kind != TokenKind::LEFT_PARENTHESIS){
+                    const OperatorInfo& waiting = table[stack.top().op];
+                    if (waiting.precedence > info.precedence || (waiting.precedence == info.precedence && info.rightAssociative))
+                        break;
+                    emit(stack.pop_and_get());
                 }
                 // push operator to stack
                 stack.push(token);
+                break;
             }
-            // invalid token
-            else{
-                std::cerr << "Error: Invalid token '" << token << "' in input.\n";
-            }
+        }
+    }
+
+    // converts a set of infix tokens to a set of postfix tokens
+    void infixToPostfix(const MyVector<Token>& infix_tokens, MyVector<Token>& postfix_tokens)
+    {
+        auto emit = [&postfix_tokens](const Token& token){
+            postfix_tokens.push_back(token);
+        };
+
+        for (const Token& token : infix_tokens){
+            shunt(token, operatorStack, emit);
         }
 
-        while(!(stack.empty())){
-            postfix_tokens.push_back(stack.top());
-            stack.pop();
+        while (!(operatorStack.empty())){
+            postfix_tokens.push_back(operatorStack.pop_and_get());
         }
     }
 
-    // calculates the final result from postfix tokens
-    double calPostfix(const MyVector<std::string>& postfix_tokens) const
+    // translates postfix tokens into bytecode and checks that every operator has its operands
+    // an expression that fails the check is left not valid, with the error in its status
+    // every distinct variable gets the next free slot, in order of first appearance
+    CompiledExpression assemble(const MyVector<Token>& postfix_tokens) const
     {
-        MyStack<double> stack;
+        const OperatorInfo* table = operatorTable();
+        CompiledExpression e;
+        e.code.reserve(postfix_tokens.size());
+        size_t depth = 0;
 
-        for(const std::string& token : postfix_tokens){
-            // digit
-            if(isDigit(token[0]) || token.length() > 1 && token[0] == '-'){
-                stack.push(std::stod(token));
-            }
-            // operator
-            else{
+        size_t literalsLength = 0;
+        for (const Token& token : postfix_tokens){
+            if (token.kind == TokenKind::NUMBER)
+                literalsLength += token.length + 1;
+        }
+        e.literals.reserve(literalsLength);
 
-                if(stack.size() < 2){
-                    std::cerr << "Error: Not enough operands for operator " << token << ".\n";
-                    return 0.0;
+        for(const Token& token : postfix_tokens){
+            // variable
+            if(token.kind == TokenKind::VARIABLE){
+                int slot = e.slot(token.name, token.length);
+                if (slot < 0){
+                    slot = static_cast<int>(e.variables.size());
+                    e.variables.push_back(std::string(token.name, token.length));
                 }
 
-                // get values from stack
-                double right = stack.top();
-                stack.pop();
-                double left = stack.top();
-                stack.pop();
-
-                // apply operator and push to stack
-                switch(token[0]){
-                    case '+':
-                        stack.push(left + right);
-                        break;
-                    case '-':
-                        stack.push(left - right);
-                        break;
-                    case '*':
-                        stack.push(left * right);
-                        break;
-                    case '/':
-                        // zero division
-                        if (right == 0)
-                        {
-                            std::cerr << "Error: Division by zero.\n";
-                            return 0.0;
-                        }
-                        stack.push(left / right);
-                        break;
-                    default:
-                        // unknown operator
-                        std::cerr << "Error: Unknown operator '" << token << "'.\n";
-                        return 0.0;
+                e.code.push_back(Instruction{OpCode::LOAD, token.position, 0.0, static_cast<size_t>(slot)});
+                depth++;
+                e.maxDepth = std::max(e.maxDepth, depth);
+            }
+            // digit
+            else if(token.kind == TokenKind::NUMBER){
+                e.code.push_back(Instruction{OpCode::PUSH, token.position, token.value, e.literals.size()});
+                e.literals.append(token.name, token.length);
+                e.literals += ' ';
+                depth++;
+                e.maxDepth = std::max(e.maxDepth, depth);
+            }
+            // operator or function
+            else if(token.kind == TokenKind::OPERATOR || token.kind == TokenKind::FUNCTION){
+                const OperatorInfo& info = table[token.op];
+                if(depth < static_cast<size_t>(info.arity)){
+                    e.status = failure(CalcError::MISSING_OPERAND, token.position, static_cast<unsigned>(token.length));
+                    return e;
                 }
+
+                e.code.push_back(Instruction{info.op, token.position, 0.0, static_cast<size_t>(token.op)});
+                depth -= info.arity - 1;
+            }
+            // an open parenthesis that was never closed
+            else{
+                e.status = failure(depth < 2 ? CalcError::MISSING_OPERAND : CalcError::UNCLOSED_PARENTHESIS, token.position, 1);
+                return e;
             }
         }
 
-        if (stack.size() != 1){
-            std::cerr << "Error: Invalid postfix expression.\n";
-            return 0.0;
+        if (depth != 1){
+            e.status = failure(CalcError::INVALID_EXPRESSION, 0, 0);
+            return e;
         }
 
-        return stack.top();
+        e.valid = true;
+        return e;
     }
 };
 
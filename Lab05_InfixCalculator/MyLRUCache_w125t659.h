@@ -0,0 +1,80 @@
+#ifndef __MYLRUCACHE_H__
+#define __MYLRUCACHE_H__
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// a fixed-capacity map that evicts the least recently used entry when it runs out of room
+template <typename KeyType, typename ValueType>
+class MyLRUCache
+{
+  private:
+    typedef std::list<std::pair<KeyType, ValueType> > EntryList;
+
+    size_t theCapacity;     // maximum number of entries kept
+    EntryList entries;      // most recently used entry first
+    std::unordered_map<KeyType, typename EntryList::iterator> index;
+
+  public:
+
+    explicit MyLRUCache(size_t capacity = 64) :
+        theCapacity{capacity}
+    {
+        ;
+    }
+
+    // returns the value cached for key and marks it as most recently used; nullptr if absent
+    ValueType * get(const KeyType & key)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+            return nullptr;
+
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->second;
+    }
+
+    // caches value under key, evicting the least recently used entry if the cache is full
+    // the cache must have a non-zero capacity
+    ValueType & put(const KeyType & key, ValueType && value)
+    {
+        auto it = index.find(key);
+        if (it != index.end()){
+            it->second->second = std::move(value);
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->second;
+        }
+
+        if (entries.size() == theCapacity){
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+
+        entries.emplace_front(key, std::move(value));
+        index[key] = entries.begin();
+        return entries.front().second;
+    }
+
+    // removes all entries
+    void clear()
+    {
+        index.clear();
+        entries.clear();
+    }
+
+    // access the number of cached entries
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    // access the capacity of the cache
+    size_t capacity() const
+    {
+        return theCapacity;
+    }
+};
+
+
+#endif // __MYLRUCACHE_H__
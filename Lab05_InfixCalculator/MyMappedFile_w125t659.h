@@ -0,0 +1,94 @@
+#ifndef __MYMAPPEDFILE_H__
+#define __MYMAPPEDFILE_H__
+
+#include <cstddef>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// a read-only view of a whole file, mapped into memory instead of read into a buffer
+// pages are loaded by the kernel as they are first touched, so even huge files open instantly
+class MyMappedFile
+{
+  private:
+    char *mapped;       // the start of the mapping; nullptr while nothing is mapped
+    size_t length;      // the size of the file
+
+    void close()
+    {
+        if (mapped != nullptr)
+            munmap(mapped, length);
+        mapped = nullptr;
+        length = 0;
+    }
+
+  public:
+
+    MyMappedFile() :
+        mapped{nullptr},
+        length{0}
+    {
+        ;
+    }
+
+    // the mapping is owned by this object and cannot be copied
+    MyMappedFile(const MyMappedFile & rhs) = delete;
+    MyMappedFile & operator= (const MyMappedFile & rhs) = delete;
+
+    ~MyMappedFile()
+    {
+        close();
+    }
+
+    // maps the file at path, replacing whatever was mapped before; returns false if it cannot be read
+    // an empty file opens fine with size() 0, as there is nothing to map
+    bool open(const std::string & path)
+    {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0){
+            ::close(fd);
+            return false;
+        }
+
+        if (info.st_size > 0){
+            void *p = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED){
+                ::close(fd);
+                return false;
+            }
+            mapped = static_cast<char*>(p);
+            length = info.st_size;
+
+            // the file is read front to back, so let the kernel read ahead aggressively
+            madvise(mapped, length, MADV_SEQUENTIAL);
+        }
+
+        // the mapping stays valid once the descriptor is closed
+        ::close(fd);
+        return true;
+    }
+
+    // access the contents of the file; not null-terminated
+    const char * data() const
+    {
+        return mapped;
+    }
+
+    // access the size of the file in bytes
+    size_t size() const
+    {
+        return length;
+    }
+};
+
+
+#endif // __MYMAPPEDFILE_H__
@@ -0,0 +1,103 @@
+#ifndef __MYOPERATORTABLE_H__
+#define __MYOPERATORTABLE_H__
+
+#include <cmath>
+#include <cstring>
+
+// the operations of a compiled expression
+enum class OpCode : unsigned char
+{
+    PUSH,       // push the constant operand
+    LOAD,       // push the value bound to variable slot `slot`
+    NEG,        // negate the top of the stack
+    SAVE,       // copy the top of the stack into temporary `slot`, leaving it on the stack
+    TEMP,       // push temporary `slot`
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    CALL1,      // replace the top of the stack by the unary kernel of operator `slot`
+    CALL2       // replace the top two values of the stack by the binary kernel of operator `slot`
+};
+
+// everything the calculator knows about one operator or function
+// the parser, the optimizer and the evaluators all work from this table, so adding an operator
+// only takes a new row: it runs through CALL1 or CALL2 and needs no new case in any evaluation loop
+struct OperatorInfo
+{
+    const char* symbol;         // how the operator is written; a function's name
+    int precedence;             // the smaller the number the higher the precedence; 0 for functions
+    bool rightAssociative;
+    bool function;              // written name(arguments) rather than between or before its operands
+    int arity;                  // 1 for prefix operators and one-argument functions, otherwise 2
+    OpCode op;                  // how evaluate() runs it: a dedicated opcode for the basic arithmetic, else CALL1/CALL2
+    double (*unary)(double);            // the kernel of an operator of arity 1
+    double (*binary)(double, double);   // the kernel of an operator of arity 2
+};
+
+// the kernels of the operators
+inline double addKernel(double a, double b) { return a + b; }
+inline double subtractKernel(double a, double b) { return a - b; }
+inline double multiplyKernel(double a, double b) { return a * b; }
+inline double divideKernel(double a, double b) { return a / b; }
+inline double moduloKernel(double a, double b) { return std::fmod(a, b); }
+inline double powerKernel(double a, double b) { return std::pow(a, b); }
+inline double negateKernel(double a) { return -a; }
+inline double lessKernel(double a, double b) { return a < b ? 1.0 : 0.0; }
+inline double lessEqualKernel(double a, double b) { return a <= b ? 1.0 : 0.0; }
+inline double greaterKernel(double a, double b) { return a > b ? 1.0 : 0.0; }
+inline double greaterEqualKernel(double a, double b) { return a >= b ? 1.0 : 0.0; }
+inline double equalKernel(double a, double b) { return a == b ? 1.0 : 0.0; }
+inline double notEqualKernel(double a, double b) { return a != b ? 1.0 : 0.0; }
+inline double minKernel(double a, double b) { return std::fmin(a, b); }
+inline double maxKernel(double a, double b) { return std::fmax(a, b); }
+inline double sqrtKernel(double a) { return std::sqrt(a); }
+inline double absKernel(double a) { return std::fabs(a); }
+
+// the positions of the operators the parser refers to directly
+enum OperatorIndex
+{
+    OPERATOR_SUBTRACT = 1,
+    OPERATOR_NEGATE = 6,
+    OPERATOR_COUNT = 17
+};
+
+// the table of every operator and function, in no particular order
+inline const OperatorInfo * operatorTable()
+{
+    static const OperatorInfo table[OPERATOR_COUNT] = {
+        {"+",    4, false, false, 2, OpCode::ADD,   nullptr,       addKernel},
+        {"-",    4, false, false, 2, OpCode::SUB,   nullptr,       subtractKernel},
+        {"*",    3, false, false, 2, OpCode::MUL,   nullptr,       multiplyKernel},
+        {"/",    3, false, false, 2, OpCode::DIV,   nullptr,       divideKernel},
+        {"%",    3, false, false, 2, OpCode::CALL2, nullptr,       moduloKernel},
+        {"^",    1, true,  false, 2, OpCode::CALL2, nullptr,       powerKernel},
+        {"-",    2, true,  false, 1, OpCode::NEG,   negateKernel,  nullptr},
+        {"<",    5, false, false, 2, OpCode::CALL2, nullptr,       lessKernel},
+        {"<=",   5, false, false, 2, OpCode::CALL2, nullptr,       lessEqualKernel},
+        {">",    5, false, false, 2, OpCode::CALL2, nullptr,       greaterKernel},
+        {">=",   5, false, false, 2, OpCode::CALL2, nullptr,       greaterEqualKernel},
+        {"==",   6, false, false, 2, OpCode::CALL2, nullptr,       equalKernel},
+        {"!=",   6, false, false, 2, OpCode::CALL2, nullptr,       notEqualKernel},
+        {"min",  0, false, true,  2, OpCode::CALL2, nullptr,       minKernel},
+        {"max",  0, false, true,  2, OpCode::CALL2, nullptr,       maxKernel},
+        {"sqrt", 0, false, true,  1, OpCode::CALL1, sqrtKernel,    nullptr},
+        {"abs",  0, false, true,  1, OpCode::CALL1, absKernel,     nullptr}
+    };
+    return table;
+}
+
+// returns the index of the binary operator or function written as the length characters at text; -1 if none
+// the prefix minus is never returned, as it is written like the binary one
+inline int findOperator(const char* text, size_t length)
+{
+    const OperatorInfo* table = operatorTable();
+    for (int i = 0; i < OPERATOR_COUNT; i++){
+        if (i != OPERATOR_NEGATE && std::strlen(table[i].symbol) == length && std::strncmp(table[i].symbol, text, length) == 0)
+            return i;
+    }
+    return -1;
+}
+
+
+#endif // __MYOPERATORTABLE_H__
@@ -0,0 +1,198 @@
+#ifndef __MYQUEUE_H__
+#define __MYQUEUE_H__
+
+#include <iostream>
+#include <algorithm>
+#include <new>
+#include <utility>
+
+template <typename DataType>
+class MyQueue
+{
+  private:
+    size_t dataStart, dataEnd;  // running positions of the first element and one past the last element
+    size_t theCapacity;         // number of slots in the ring; always a power of two
+    DataType *queueData;        // raw circular storage; slots in [dataStart, dataEnd) hold constructed elements
+
+    // maps a running position onto a slot of the ring
+    size_t slot(size_t pos) const
+    {
+        return pos & (theCapacity - 1);
+    }
+
+    // allocates uninitialized storage for n data elements
+    static DataType * allocate(size_t n)
+    {
+        return static_cast<DataType*>(::operator new(n * sizeof(DataType)));
+    }
+
+    // destroys all elements and returns the storage
+    void release()
+    {
+        for (size_t i = dataStart; i != dataEnd; i++){
+            queueData[slot(i)].~DataType();
+        }
+        ::operator delete(queueData);
+    }
+
+    // changes the size of the array to newSize
+    void resize(size_t newSize)
+    {
+        reserve(newSize * 2);
+    }
+
+    // requests for newCapacity amount of space; rounded up to a power of two
+    // the elements are moved (not copied) into the new ring, unwrapped to start at slot 0
+    void reserve(size_t newCapacity)
+    {
+        if(theCapacity >= newCapacity){
+            return;
+        }
+
+        // a moved-from queue has no storage at all
+        size_t cap = theCapacity == 0 ? SPARE_CAPACITY : theCapacity;
+        while(cap < newCapacity){
+            cap *= 2;
+        }
+
+        DataType *newData = allocate(cap);
+        size_t n = size();
+        for(size_t i = 0; i < n; i++){
+            DataType& x = queueData[slot(dataStart + i)];
+            new (&newData[i]) DataType(std::move(x));
+            x.~DataType();
+        }
+        ::operator delete(queueData);
+
+        queueData = newData;
+        theCapacity = cap;
+        dataStart = 0;
+        dataEnd = n;
+    }
+
+  public:
+
+    static const size_t SPARE_CAPACITY = 16;   // initial capacity of the queue, same as MyVector
+
+    // default constructor
+    explicit MyQueue(size_t initSize = 0) :
+        dataStart{0},
+        dataEnd{0},
+        theCapacity{SPARE_CAPACITY}
+    {
+        while(theCapacity < initSize){
+            theCapacity *= 2;
+        }
+        queueData = allocate(theCapacity);
+    }
+
+    // copy constructor
+    MyQueue(const MyQueue & rhs) :
+        dataStart{0},
+        dataEnd{0},
+        theCapacity{rhs.theCapacity},
+        queueData{allocate(rhs.theCapacity)}
+    {
+        for(size_t i = rhs.dataStart; i != rhs.dataEnd; i++){
+            new (&queueData[dataEnd]) DataType(rhs.queueData[rhs.slot(i)]);
+            dataEnd++;
+        }
+    }
+
+    // move constructor
+    MyQueue(MyQueue && rhs) :
+        dataStart{rhs.dataStart},
+        dataEnd{rhs.dataEnd},
+        theCapacity{rhs.theCapacity},
+        queueData{rhs.queueData}
+    {
+        rhs.dataStart = 0;
+        rhs.dataEnd = 0;
+        rhs.theCapacity = 0;
+        rhs.queueData = nullptr;
+    }
+
+    // destructor
+    ~MyQueue()
+    {
+        release();
+    }
+
+    // copy assignment
+    MyQueue & operator= (const MyQueue & rhs)
+    {
+        MyQueue copy(rhs);
+        std::swap(*this, copy);
+        return *this;
+    }
+
+    // move assignment
+    MyQueue & operator= (MyQueue && rhs)
+    {
+        std::swap(dataStart, rhs.dataStart);
+        std::swap(dataEnd, rhs.dataEnd);
+        std::swap(theCapacity, rhs.theCapacity);
+        std::swap(queueData, rhs.queueData);
+
+        return *this;
+    }
+
+    // insert x into the queue
+    void enqueue(const DataType & x)
+    {
+        if(size() == theCapacity){
+            reserve(size() + 1);
+        }
+
+        new (&queueData[slot(dataEnd)]) DataType(x);
+        dataEnd++;
+    }
+
+    // insert x into the queue
+    void enqueue(DataType && x)
+    {
+        if(size() == theCapacity){
+            reserve(size() + 1);
+        }
+
+        new (&queueData[slot(dataEnd)]) DataType(std::move(x));
+        dataEnd++;
+    }
+
+    // remove the first element from the queue; never moves the remaining elements
+    void dequeue(void)
+    {
+        if (!empty()) {
+            queueData[slot(dataStart)].~DataType();
+            dataStart++;
+        }
+    }
+
+    // access the first element of the queue
+    const DataType & front(void) const
+    {
+        return queueData[slot(dataStart)];
+    }
+
+    // check if the queue is empty; return TRUE is empty; FALSE otherwise
+    bool empty(void) const
+    {
+        return dataStart == dataEnd;
+    }
+
+    // access the size of the queue
+    size_t size() const
+    {
+        return dataEnd - dataStart;
+    }
+
+    // access the capacity of the queue
+    size_t capacity(void) const
+    {
+        return theCapacity;
+    }
+
+};
+
+
+#endif // __MYQUEUE_H__
@@ -37,7 +37,7 @@ class MyVector
     }
 
     // move constructor
-    MyVector(MyVector&& rhs):
+    MyVector(MyVector&& rhs) noexcept :
         theSize{rhs.theSize},
         theCapacity{rhs.theCapacity},
         data{rhs.data}
@@ -72,7 +72,7 @@ class MyVector
     }
 
     // move assignment
-    MyVector & operator= (MyVector && rhs)
+    MyVector & operator= (MyVector && rhs) noexcept
     {
         std::swap(theSize, rhs.theSize);
         std::swap(theCapacity, rhs.theCapacity);
@@ -110,6 +110,22 @@ class MyVector
         data = newTemp;
     }
 
+    // release the spare capacity, e.g. of a vector that is kept for long and will not grow
+    void shrink_to_fit()
+    {
+        if (theCapacity == theSize)
+            return;
+
+        DataType *newTemp = new DataType[theSize];
+        for(size_t i = 0; i < theSize; i++){
+            newTemp[i] = std::move(data[i]);
+        }
+
+        delete[] data;
+        theCapacity = theSize;
+        data = newTemp;
+    }
+
     // data access operator (without bound checking)
     DataType & operator[] (size_t index)
     {
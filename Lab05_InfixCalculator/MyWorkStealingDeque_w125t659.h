@@ -0,0 +1,166 @@
+#ifndef __MYWORKSTEALINGDEQUE_H__
+#define __MYWORKSTEALINGDEQUE_H__
+
+#include <atomic>
+#include <vector>
+
+// a Chase-Lev work-stealing deque (with the C11 memory orders of Le, Pop, Cohen and Zappa Nardelli)
+// the owner thread pushes and pops at the bottom (LIFO, like MyStack);
+// any other thread may steal from the top (FIFO, like MyQueue)
+// DataType should be a pointer or another small trivially copyable type, as slots are plain atomics
+template <typename DataType>
+class MyWorkStealingDeque
+{
+  private:
+    static const size_t CACHE_LINE = 64;    // size of a cache line on the targeted machines
+
+    // a circular array of slots; replaced by a twice larger one when the owner runs out of room
+    struct Ring
+    {
+        long long theCapacity;              // always a power of two
+        std::atomic<DataType> *slots;
+
+        explicit Ring(long long capacity) :
+            theCapacity{capacity},
+            slots{new std::atomic<DataType>[capacity]}
+        {
+            ;
+        }
+
+        ~Ring()
+        {
+            delete [] slots;
+        }
+
+        DataType get(long long i) const
+        {
+            return slots[i & (theCapacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(long long i, DataType x)
+        {
+            slots[i & (theCapacity - 1)].store(x, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<long long> top;         // next position to steal from; only ever increases
+    char pad0[CACHE_LINE - sizeof(std::atomic<long long>)];
+
+    std::atomic<long long> bottom;      // next position the owner pushes to
+    std::atomic<Ring*> ring;
+    char pad1[CACHE_LINE - sizeof(std::atomic<long long>) - sizeof(std::atomic<Ring*>)];
+
+    // rings replaced by a larger one; a thief may still be reading them, so they live until destruction
+    std::vector<Ring*> retired;
+
+    // copies the live range [t, b) into a ring of twice the capacity
+    Ring * grow(Ring *old, long long t, long long b)
+    {
+        Ring *r = new Ring(old->theCapacity * 2);
+        for (long long i = t; i < b; i++){
+            r->put(i, old->get(i));
+        }
+        retired.push_back(old);
+        ring.store(r, std::memory_order_release);
+        return r;
+    }
+
+  public:
+
+    // creates a deque with room for initCapacity elements before it first grows (rounded up to a power of two)
+    explicit MyWorkStealingDeque(size_t initCapacity = 256) :
+        top{0},
+        bottom{0}
+    {
+        long long capacity = 2;
+        while (capacity < static_cast<long long>(initCapacity)){
+            capacity *= 2;
+        }
+        ring.store(new Ring(capacity), std::memory_order_relaxed);
+    }
+
+    // the deque is shared between threads and cannot be copied or moved
+    MyWorkStealingDeque(const MyWorkStealingDeque & rhs) = delete;
+    MyWorkStealingDeque & operator= (const MyWorkStealingDeque & rhs) = delete;
+
+    // destructor; must not race with any other thread
+    ~MyWorkStealingDeque()
+    {
+        delete ring.load(std::memory_order_relaxed);
+        for (Ring *r : retired){
+            delete r;
+        }
+    }
+
+    // owner only: insert x at the bottom
+    void push(DataType x)
+    {
+        long long b = bottom.load(std::memory_order_relaxed);
+        long long t = top.load(std::memory_order_acquire);
+        Ring *r = ring.load(std::memory_order_relaxed);
+        if (b - t > r->theCapacity - 1){
+            r = grow(r, t, b);
+        }
+        r->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only: remove the most recently pushed element into x; returns false if the deque is empty
+    bool pop(DataType & x)
+    {
+        long long b = bottom.load(std::memory_order_relaxed) - 1;
+        Ring *r = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long t = top.load(std::memory_order_relaxed);
+
+        if (t > b){
+            // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        x = r->get(b);
+        if (t == b){
+            // the last element; race the thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // any thread: remove the oldest element into x; returns false if the deque is empty
+    // or another thread took that element first
+    bool steal(DataType & x)
+    {
+        long long t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+            return false;
+
+        Ring *r = ring.load(std::memory_order_acquire);
+        x = r->get(t);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    // check if the deque is empty; only a snapshot while other threads are running
+    bool empty(void) const
+    {
+        return size() == 0;
+    }
+
+    // access the size of the deque; only a snapshot while other threads are running
+    size_t size() const
+    {
+        long long t = top.load(std::memory_order_acquire);
+        long long b = bottom.load(std::memory_order_acquire);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+};
+
+
+#endif // __MYWORKSTEALINGDEQUE_H__
@@ -0,0 +1,588 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+#include "MyHashTable_w125t659.h"
+#include "MyFlatHashTable_w125t659.h"
+
+using namespace std;
+
+// the largest number of keys the chained table is benchmarked with; beyond it the bucket lists alone
+// (a list object and two sentinel nodes per bucket, at twice as many buckets as keys) outgrow the memory
+static const size_t CHAINED_LIMIT = 1000000;
+
+// every heap allocation made by the program is counted here
+static size_t allocations = 0;
+
+// every replaced operator new and delete below goes through these two
+// they are kept out of line so that the compiler does not see free() called on memory from operator new,
+// which -Wall reports as a mismatched deallocation
+__attribute__((noinline)) void * countedAllocate(size_t n)
+{
+    ++ allocations;
+    void *p = malloc(n == 0 ? 1 : n);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void countedFree(void *p) noexcept
+{
+    free(p);
+}
+
+void * operator new(size_t n)
+{
+    return countedAllocate(n);
+}
+
+void * operator new[](size_t n)
+{
+    return countedAllocate(n);
+}
+
+void operator delete(void *p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+// a long long key whose hashes are counted, to see how many hashes each operation of MyHashTable computes
+struct CountedKey
+{
+    long long k;
+
+    CountedKey(long long key = 0) :
+        k{key}
+    { }
+
+    bool operator==(const CountedKey& rhs) const
+    {
+        return k == rhs.k;
+    }
+};
+
+static size_t hash_calls = 0;
+
+template <>
+class HashFunc<CountedKey>
+{
+  public:
+    unsigned long long fullHash(const CountedKey& key, const unsigned long long seed = 0) const
+    {
+        hash_calls++;
+        return HashFunc<long long>().fullHash(key.k, seed);
+    }
+};
+
+template <>
+struct FullHashMixed<CountedKey>
+{
+    static const bool value = true;     // the hash of the long long key
+};
+
+// runs f once and returns the elapsed time in milliseconds
+template <typename Func>
+double timeIt(Func f)
+{
+    auto start = chrono::steady_clock::now();
+    f();
+    auto stop = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(stop - start).count();
+}
+
+// runs the same random inserts, removes and retrievals on MyHashTable, on its variants (rehashing
+// incrementally, and with power-of-two table sizes), and on MyFlatHashTable, and counts the answers that differ
+template <typename KeyType>
+size_t crossCheck(const vector<KeyType>& pool, size_t operations, unsigned seed)
+{
+    MyHashTable<KeyType, int> chained;
+    MyHashTable<KeyType, int> incremental(3, 2);
+    MyHashTable<KeyType, int> masked(3, 0, TableSizing::MASK);
+    MyHashTable<KeyType, int> fastrange(3, 2, TableSizing::FASTRANGE);
+    MyHashTable<KeyType, int>* variants[] = {&incremental, &masked, &fastrange};
+    MyFlatHashTable<KeyType, int> flat;
+    mt19937 rng(seed);
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < operations; i++){
+        const KeyType& key = pool[rng() % pool.size()];
+        int value = static_cast<int>(rng() % 1000);
+        HashedObj<KeyType, int> a, b;
+
+        // alternate between phases that mostly insert and phases that mostly remove, so both tables
+        // grow and shrink several times
+        unsigned op = rng() % 4;
+        unsigned inserts = (i / 20000) % 2 == 0 ? 2 : 1;
+        // the chained table answers half of them through its single-probe operations
+        bool probe = rng() % 2 == 0;
+        if (op < inserts){
+            bool inserted = probe ? chained.try_emplace(key, value).second : chained.insert(HashedObj<KeyType, int>(key, value));
+            mismatches += inserted != flat.insert(HashedObj<KeyType, int>(key, value));
+            for (auto variant : variants){
+                mismatches += inserted != variant->insert(HashedObj<KeyType, int>(key, value));
+            }
+        }
+        else if (op < 3){
+            bool removed = probe ? chained.erase(chained.find(key)) : chained.remove(key);
+            mismatches += removed != flat.remove(key);
+            for (auto variant : variants){
+                mismatches += removed != variant->remove(key);
+            }
+        }
+        else{
+            bool found = chained.retrieve(key, a);
+            mismatches += found != flat.retrieve(key, b) || (found && (a.key != b.key || a.value != b.value));
+            for (auto variant : variants){
+                mismatches += found != variant->retrieve(key, b) || (found && (a.key != b.key || a.value != b.value));
+            }
+        }
+        mismatches += chained.size() != flat.size();
+        for (auto variant : variants){
+            mismatches += chained.size() != variant->size();
+        }
+    }
+    return mismatches;
+}
+
+// times inserting every key, retrieving every key in another order, looking up keys that are absent,
+// and removing every key; prints nanoseconds per operation and returns a checksum of what was found
+template <typename Table, typename KeyType>
+long long benchTable(const string& name, const vector<KeyType>& keys, const vector<KeyType>& lookups,
+                     const vector<KeyType>& misses)
+{
+    Table* table = new Table();
+    long long checksum = 0;
+    size_t n = keys.size();
+
+    double t_insert = timeIt([&]{
+        for (size_t i = 0; i < n; i++){
+            checksum += table->insert(HashedObj<KeyType, long long>(KeyType(keys[i]), static_cast<long long>(i)));
+        }
+    });
+    size_t capacity = table->capacity();
+
+    double t_hit = timeIt([&]{
+        HashedObj<KeyType, long long> data;
+        for (size_t i = 0; i < n; i++){
+            if (table->retrieve(lookups[i], data))
+                checksum += data.value;
+        }
+    });
+
+    double t_miss = timeIt([&]{
+        for (size_t i = 0; i < n; i++){
+            checksum += table->contains(misses[i]);
+        }
+    });
+
+    double t_remove = timeIt([&]{
+        for (size_t i = 0; i < n; i++){
+            checksum += table->remove(lookups[i]);
+        }
+    });
+
+    double t_free = timeIt([&]{ delete table; });
+
+    cout << "  " << name << "\t" << 1e6 * t_insert / n << "\t" << 1e6 * t_hit / n << "\t"
+         << 1e6 * t_miss / n << "\t" << 1e6 * t_remove / n << "\t" << t_free << " ms\t"
+         << capacity << endl;
+    return checksum;
+}
+
+// a MyHashTable that is default-constructed with the given table sizing, for benchTable()
+template <typename KeyType, typename ValueType, TableSizing sizing>
+class SizedHashTable : public MyHashTable<KeyType, ValueType>
+{
+  public:
+    SizedHashTable() :
+        MyHashTable<KeyType, ValueType>(3, 0, sizing)
+    { }
+};
+
+// benchmarks MyHashTable under each table sizing; flat is the checksum of MyFlatHashTable on the same keys
+template <typename KeyType>
+void benchChained(const vector<KeyType>& keys, const vector<KeyType>& lookups, const vector<KeyType>& misses,
+                  long long flat)
+{
+    long long prime = benchTable<SizedHashTable<KeyType, long long, TableSizing::PRIME> >(
+        "prime  ", keys, lookups, misses);
+    long long mask = benchTable<SizedHashTable<KeyType, long long, TableSizing::MASK> >(
+        "mask   ", keys, lookups, misses);
+    long long fastrange = benchTable<SizedHashTable<KeyType, long long, TableSizing::FASTRANGE> >(
+        "fastrange", keys, lookups, misses);
+    if (prime != flat || mask != flat || fastrange != flat)
+        cout << "  ERROR: the tables found different data" << endl;
+}
+
+// benchmarks both tables with n integer keys; the keys are distinct and inserted in random order
+void benchIntegers(size_t n)
+{
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; i++){
+        keys[i] = static_cast<long long>(i) * 40503 + 1;
+    }
+    mt19937_64 rng(n);
+    shuffle(keys.begin(), keys.end(), rng);
+
+    vector<long long> lookups(keys);
+    shuffle(lookups.begin(), lookups.end(), rng);
+
+    // no multiple of 40503 plus 2 is a key
+    vector<long long> misses(n);
+    for (size_t i = 0; i < n; i++){
+        misses[i] = keys[i] + 1;
+    }
+
+    cout << n << " long long keys" << endl;
+    long long flat = benchTable<MyFlatHashTable<long long, long long> >("flat   ", keys, lookups, misses);
+    if (n <= CHAINED_LIMIT)
+        benchChained(keys, lookups, misses, flat);
+}
+
+// benchmarks both tables with n string keys like those of the lab inputs, but longer
+void benchStrings(size_t n)
+{
+    vector<string> keys(n);
+    vector<string> misses(n);
+    for (size_t i = 0; i < n; i++){
+        keys[i] = "key_" + to_string(i * 40503 + 1);
+        misses[i] = "miss_" + to_string(i * 40503 + 1);
+    }
+    mt19937_64 rng(n);
+    shuffle(keys.begin(), keys.end(), rng);
+
+    vector<string> lookups(keys);
+    shuffle(lookups.begin(), lookups.end(), rng);
+
+    cout << n << " string keys" << endl;
+    long long flat = benchTable<MyFlatHashTable<string, long long> >("flat   ", keys, lookups, misses);
+    benchChained(keys, lookups, misses, flat);
+}
+
+// times one kind of operation over n keys and prints ns and hashes per operation
+template <typename Func>
+void benchProbe(const string& name, size_t n, Func f)
+{
+    hash_calls = 0;
+    double t = timeIt(f);
+    cout << "  " << name << "\t" << 1e6 * t / n << "\t" << static_cast<double>(hash_calls) / n << endl;
+}
+
+// benchmarks the operations of MyHashTable by the number of times each hashes its key
+void benchSingleProbe(size_t n)
+{
+    vector<CountedKey> keys(n);
+    for (size_t i = 0; i < n; i++){
+        keys[i] = CountedKey(static_cast<long long>(i) * 40503 + 1);
+    }
+    mt19937_64 rng(n);
+    shuffle(keys.begin(), keys.end(), rng);
+
+    MyHashTable<CountedKey, long long> table;
+    HashedObj<CountedKey, long long> data;
+    long long checksum = 0;
+
+    cout << "MyHashTable with " << n << " keys:\tns/op\thashes/op" << endl;
+    benchProbe("insert\t\t", n, [&]{
+        for (size_t i = 0; i < n; i++){
+            table.insert(HashedObj<CountedKey, long long>(CountedKey(keys[i]), static_cast<long long>(i)));
+        }
+    });
+    benchProbe("retrieve\t", n, [&]{
+        for (size_t i = 0; i < n; i++){
+            if (table.retrieve(keys[i], data))
+                checksum += data.value;
+        }
+    });
+    benchProbe("find\t\t", n, [&]{
+        for (size_t i = 0; i < n; i++){
+            auto h = table.find(keys[i]);
+            if (h)
+                checksum += h->value;
+        }
+    });
+    benchProbe("try_emplace (present)", n, [&]{
+        for (size_t i = 0; i < n; i++){
+            checksum += table.try_emplace(keys[i], 0).second;
+        }
+    });
+    benchProbe("insert_or_assign (present)", n, [&]{
+        for (size_t i = 0; i < n; i++){
+            checksum += table.insert_or_assign(keys[i], static_cast<long long>(i)).second;
+        }
+    });
+    benchProbe("find + erase(handle)", n / 2, [&]{
+        for (size_t i = 0; i < n / 2; i++){
+            checksum += table.erase(table.find(keys[i]));
+        }
+    });
+    benchProbe("remove\t\t", n - n / 2, [&]{
+        for (size_t i = n / 2; i < n; i++){
+            checksum += table.remove(keys[i]);
+        }
+    });
+    benchProbe("try_emplace (new)", n, [&]{
+        for (size_t i = 0; i < n; i++){
+            checksum += table.try_emplace(keys[i], static_cast<long long>(i)).second;
+        }
+    });
+
+    // every lookup found its key, nothing was inserted twice, and every key was erased once then re-inserted
+    long long expected = 2 * (static_cast<long long>(n) * (n - 1) / 2) + 2 * static_cast<long long>(n);
+    if (checksum != expected || table.size() != n)
+        cout << "  ERROR: unexpected results from the single-probe operations" << endl;
+}
+
+// sorts the latencies of one kind of operation and prints their percentiles
+void printLatencies(const string& name, vector<double>& latencies, double total)
+{
+    size_t n = latencies.size();
+    sort(latencies.begin(), latencies.end());
+    cout << "  " << name << "\t" << latencies[n / 2] << "\t" << latencies[n * 99 / 100] << "\t"
+         << latencies[n * 999 / 1000] << "\t" << latencies[n - 1] << "\t" << total << " ms" << endl;
+}
+
+// times every single insertion of n keys into a MyHashTable with the given rehash step, then every
+// single removal of them, and prints the percentiles of their latencies
+// the slowest ones are those that grow the table, and those that shrink it
+void benchLatency(size_t n, size_t rehash_step)
+{
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; i++){
+        keys[i] = static_cast<long long>(i) * 40503 + 1;
+    }
+    mt19937_64 rng(n);
+    shuffle(keys.begin(), keys.end(), rng);
+
+    // glibc keeps small freed blocks unmerged and merges all of them on the next large allocation; after
+    // a million removals that one allocation, here the table that a shrink makes, stalls for a second
+    // whatever the table does, so the blocks are merged as they are freed instead
+    mallopt(M_MXFAST, 0);
+
+    MyHashTable<long long, long long> table(3, rehash_step);
+    vector<double> latencies(n);
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++){
+        auto before = chrono::steady_clock::now();
+        table.insert(HashedObj<long long, long long>(static_cast<long long>(keys[i]), static_cast<long long>(i)));
+        auto after = chrono::steady_clock::now();
+        latencies[i] = chrono::duration<double, micro>(after - before).count();
+    }
+    double total = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    string name = rehash_step == 0 ? string("all at once") : "step " + to_string(rehash_step);
+    printLatencies(name + ", insert", latencies, total);
+    if (table.size() != n)
+        cout << "  ERROR: " << table.size() << " keys in the table" << endl;
+
+    shuffle(keys.begin(), keys.end(), rng);
+    size_t removed = 0;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++){
+        auto before = chrono::steady_clock::now();
+        removed += table.remove(keys[i]);
+        auto after = chrono::steady_clock::now();
+        latencies[i] = chrono::duration<double, micro>(after - before).count();
+    }
+    total = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    printLatencies(name + ", remove", latencies, total);
+    if (removed != n || table.size() != 0)
+        cout << "  ERROR: " << removed << " keys removed, " << table.size() << " left" << endl;
+
+    // glibc's default
+    mallopt(M_MXFAST, 64 * sizeof(size_t) / 4);
+}
+
+// inserts n string keys into a MyHashTable with the given table sizing and times the insertions
+// that resize the table, along with the heap allocations they make
+void benchRehash(size_t n, TableSizing sizing, const string& name)
+{
+    // the benchmarks before freed millions of small blocks, which the allocator would sort out a few
+    // thousand at a time in the allocations timed below; it does all of them here instead
+    malloc_trim(0);
+
+    MyHashTable<string, long long> table(3, 0, sizing);
+    size_t resizes = 0;
+    size_t resize_allocations = 0;
+    double resize_time = 0.0;
+    double last_time = 0.0;
+    size_t last_size = 0;
+
+    double total = timeIt([&]{
+        for (size_t i = 0; i < n; i++){
+            HashedObj<string, long long> x("key_" + to_string(i * 40503 + 1), static_cast<long long>(i));
+            size_t capacity = table.capacity();
+            size_t allocs = allocations;
+            auto before = chrono::steady_clock::now();
+            table.insert(move(x));
+            auto after = chrono::steady_clock::now();
+
+            if (table.capacity() != capacity){
+                resizes++;
+                resize_allocations += allocations - allocs;
+                last_time = chrono::duration<double, milli>(after - before).count();
+                resize_time += last_time;
+                last_size = table.size();
+            }
+        }
+    });
+
+    cout << "  " << name << "\t" << resizes << "\t" << resize_time << " ms\t" << resize_allocations << "\t"
+         << last_size << "\t" << last_time << " ms\t" << total << " ms" << endl;
+    if (table.size() != n)
+        cout << "  ERROR: " << table.size() << " keys in the table" << endl;
+}
+
+// the smallest prime not below n, by trial division
+size_t primeAtLeast(size_t n)
+{
+    for (;; n++){
+        bool prime = n >= 2;
+        for (size_t d = 2; d * d <= n && prime; d++){
+            prime = n % d != 0;
+        }
+        if (prime)
+            return n;
+    }
+}
+
+// prints how many of the hashes share their value with another one, and how they fill a table of
+// about twice as many buckets as there are hashes, i.e. how long the chains of MyHashTable would be
+void printCollisions(const string& name, vector<unsigned long long>& hashes)
+{
+    size_t n = hashes.size();
+    size_t buckets = primeAtLeast(2 * n);
+    vector<unsigned> load(buckets, 0);
+    for (unsigned long long hv : hashes){
+        load[hv % buckets]++;
+    }
+    size_t shared_bucket = 0;
+    unsigned longest = 0;
+    for (unsigned l : load){
+        if (l > 1)
+            shared_bucket += l;
+        longest = l > longest ? l : longest;
+    }
+    vector<unsigned>().swap(load);
+
+    sort(hashes.begin(), hashes.end());
+    size_t shared_hash = 0;
+    for (size_t i = 0; i < n; i++){
+        if ((i > 0 && hashes[i] == hashes[i - 1]) || (i + 1 < n && hashes[i] == hashes[i + 1]))
+            shared_hash++;
+    }
+
+    cout << "  " << name << "\t" << 100.0 * shared_hash / n << "%\t\t" << 100.0 * shared_bucket / n << "%\t\t"
+         << longest << endl;
+}
+
+// compares the lab's univHash with fullHash on string keys: the time per hash for several key lengths,
+// and how n keys like those of benchStrings collide
+void benchStringHash(size_t n)
+{
+    HashFunc<string> hash;
+    unsigned long long seed = randomSeed();
+    unsigned long long sink = 0;
+
+    cout << "String hash, ns per key:\tunivHash\tfullHash\tfullHash GB/s" << endl;
+    size_t lengths[] = {8, 16, 32, 64, 256};
+    for (size_t len : lengths){
+        size_t count = (size_t(64) << 20) / len;
+        vector<string> keys(count, string(len, ' '));
+        mt19937_64 rng(len);
+        for (string& key : keys){
+            for (char& c : key){
+                c = static_cast<char>('a' + rng() % 26);
+            }
+        }
+        double t_univ = timeIt([&]{
+            for (const string& key : keys){
+                sink += hash.univHash(key, mersenne_prime);
+            }
+        });
+        double t_full = timeIt([&]{
+            for (const string& key : keys){
+                sink += hash.fullHash(key, seed);
+            }
+        });
+        cout << "  " << len << " bytes\t\t\t" << 1e6 * t_univ / count << "\t\t" << 1e6 * t_full / count << "\t\t"
+             << static_cast<double>(len) * count / t_full / 1e6 << endl;
+    }
+
+    cout << "Collisions of " << n << " keys:\tshared hash\tshared bucket\tlongest chain" << endl;
+    vector<unsigned long long> hashes(n);
+    for (size_t i = 0; i < n; i++){
+        hashes[i] = hash.univHash("key_" + to_string(i * 40503 + 1), mersenne_prime);
+    }
+    printCollisions("univHash\t", hashes);
+    for (size_t i = 0; i < n; i++){
+        hashes[i] = hash.fullHash("key_" + to_string(i * 40503 + 1), seed);
+    }
+    printCollisions("fullHash\t", hashes);
+
+    if (sink == 0)
+        cout << "  (no hashes)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    // the largest number of keys; 50M needs about 2 GB
+    size_t max_keys = argc > 1 ? strtoull(argv[1], nullptr, 10) : 50000000;
+
+    vector<long long> ints;
+    vector<string> strings;
+    for (long long i = 0; i < 3000; i++){
+        ints.push_back(i * 7);
+        strings.push_back("k" + to_string(i));
+    }
+    size_t mismatches = crossCheck(ints, 200000, 1) + crossCheck(strings, 200000, 2);
+    cout << "Cross-check against MyHashTable: 400000 operations, " << mismatches << " mismatches" << endl;
+
+    // MyHashTable is benchmarked with prime table sizes (hv % size), and with power-of-two ones (mask, fastrange)
+    cout << "ns per operation:\tinsert\tretrieve\tmiss\tremove\tdestroy\t\tcapacity" << endl;
+    size_t sizes[] = {1000, 10000, 100000, 1000000, 10000000, 50000000};
+    for (size_t n : sizes){
+        if (n <= max_keys)
+            benchIntegers(n);
+    }
+    benchStrings(max_keys < CHAINED_LIMIT ? max_keys : CHAINED_LIMIT);
+    benchSingleProbe(max_keys < CHAINED_LIMIT ? max_keys : CHAINED_LIMIT);
+
+    size_t latency_keys = max_keys < CHAINED_LIMIT ? max_keys : CHAINED_LIMIT;
+    cout << "MyHashTable insert and remove latency, " << latency_keys << " keys (us):\tp50\tp99\tp99.9\tmax\ttotal" << endl;
+    size_t steps[] = {0, 4, 16, 64};
+    for (size_t step : steps){
+        benchLatency(latency_keys, step);
+    }
+
+    size_t rehash_keys = max_keys < 10000000 ? max_keys : 10000000;
+    cout << "MyHashTable rehash, " << rehash_keys << " string keys:\tresizes\ttime\tallocations\t"
+         << "largest at\ttime\tall insertions" << endl;
+    benchRehash(rehash_keys, TableSizing::PRIME, "prime  ");
+    benchRehash(rehash_keys, TableSizing::MASK, "mask   ");
+    benchStringHash(max_keys);
+
+    return 0;
+}
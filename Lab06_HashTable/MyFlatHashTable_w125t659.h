@@ -0,0 +1,366 @@
+#ifndef __MYFLATHASHTABLE_H__
+#define __MYFLATHASHTABLE_H__
+
+#include <new>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "MyHashTable_w125t659.h"
+
+// an open-addressing hash table with the same interface as MyHashTable
+// the data elements live in one flat array of slots, next to an array of one control byte per slot:
+// EMPTY, DELETED, or 7 bits of the hash of the key in a full slot (the Swiss table layout)
+// a lookup matches a whole group of control bytes against those 7 bits at once and only compares
+// the keys of the slots that match, so it usually touches one control group and one slot
+template <typename KeyType, typename ValueType>
+class MyFlatHashTable
+{
+  private:
+    typedef HashedObj<KeyType, ValueType> Slot;
+
+    static const signed char EMPTY = -128;      // a slot that never held data since the last rehash
+    static const signed char DELETED = -2;      // a removed slot; probing has to go on past it
+
+    static const size_t GROUP_WIDTH = 16;       // the number of control bytes matched at once
+    static const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    // a window of GROUP_WIDTH control bytes; every match returns one bit per byte, lowest bit first
+    struct Group
+    {
+#ifdef __SSE2__
+        __m128i ctrl;
+
+        explicit Group(const signed char* p) :
+            ctrl{_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))}
+        { }
+
+        unsigned match(const signed char h2) const
+        {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+        }
+
+        // EMPTY and DELETED are the only control bytes with the sign bit set
+        unsigned matchEmptyOrDeleted() const
+        {
+            return _mm_movemask_epi8(ctrl);
+        }
+#else
+        const signed char* ctrl;
+
+        explicit Group(const signed char* p) :
+            ctrl{p}
+        { }
+
+        unsigned match(const signed char h2) const
+        {
+            unsigned mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++){
+                mask |= static_cast<unsigned>(ctrl[i] == h2) << i;
+            }
+            return mask;
+        }
+
+        unsigned matchEmptyOrDeleted() const
+        {
+            unsigned mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++){
+                mask |= static_cast<unsigned>(ctrl[i] < 0) << i;
+            }
+            return mask;
+        }
+#endif
+
+        unsigned matchEmpty() const
+        {
+            return match(EMPTY);
+        }
+    };
+
+    size_t theSize;         // the number of data elements stored in the hash table
+    size_t theCapacity;     // the number of slots; a power of two, and at least GROUP_WIDTH
+    size_t growthLeft;      // the EMPTY slots that may still be filled before the table has to grow
+    signed char* ctrl;      // theCapacity control bytes, then a copy of the first GROUP_WIDTH of them
+    Slot* slots;            // raw storage; only the slots with a full control byte hold a constructed object
+    unsigned long long seed;    // the seed of this table's hash function, drawn at random
+
+    // hashes a key to the full 64 bits, of which h1() and h2() below take their parts
+    unsigned long long hashKey(const KeyType& key) const
+    {
+        return HashFunc<KeyType>().fullHash(key, seed);
+    }
+
+    // the slot index bits and the control bits of a hash
+    static size_t h1(const unsigned long long hv)
+    {
+        return static_cast<size_t>(hv >> 7);
+    }
+
+    static signed char h2(const unsigned long long hv)
+    {
+        return static_cast<signed char>(hv & 0x7F);
+    }
+
+    // the most data elements a table of the given capacity holds, i.e. a load factor of 7/8
+    static size_t maxLoad(const size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+
+    // the number of trailing and leading zero bits of a group mask
+    static size_t trailingZeros(const unsigned mask)
+    {
+        return mask == 0 ? GROUP_WIDTH : __builtin_ctz(mask);
+    }
+
+    static size_t leadingZeros(const unsigned mask)
+    {
+        return mask == 0 ? GROUP_WIDTH : __builtin_clz(mask) - (32 - GROUP_WIDTH);
+    }
+
+    // sets the control byte of a slot; the first GROUP_WIDTH bytes are mirrored past the end,
+    // so a group can be loaded at any slot without wrapping around
+    void setCtrl(const size_t index, const signed char h)
+    {
+        ctrl[index] = h;
+        if (index < GROUP_WIDTH)
+            ctrl[theCapacity + index] = h;
+    }
+
+    // allocates an empty table of the given capacity
+    void allocate(const size_t capacity)
+    {
+        theCapacity = capacity;
+        growthLeft = maxLoad(capacity);
+        ctrl = new signed char[capacity + GROUP_WIDTH];
+        for (size_t i = 0; i < capacity + GROUP_WIDTH; i++){
+            ctrl[i] = EMPTY;
+        }
+        slots = static_cast<Slot*>(::operator new(capacity * sizeof(Slot)));
+    }
+
+    // destructs the data elements and frees the arrays
+    void release()
+    {
+        for (size_t i = 0; i < theCapacity; i++){
+            if (ctrl[i] >= 0)
+                slots[i].~Slot();
+        }
+        delete[] ctrl;
+        ::operator delete(slots);
+    }
+
+    // finds the slot that holds the key, probing one group at a time (triangular steps over the groups)
+    // returns NOT_FOUND once a group with an EMPTY slot has no match, as the key would have been stored there
+    size_t find(const KeyType& key, const unsigned long long hv) const
+    {
+        const size_t mask = theCapacity - 1;
+        size_t pos = h1(hv) & mask;
+        size_t step = 0;
+        while (true){
+            Group g(ctrl + pos);
+            for (unsigned m = g.match(h2(hv)); m != 0; m &= m - 1){
+                size_t index = (pos + __builtin_ctz(m)) & mask;
+                if (slots[index].key == key)
+                    return index;
+            }
+            if (g.matchEmpty() != 0)
+                return NOT_FOUND;
+
+            step += GROUP_WIDTH;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // finds the first EMPTY or DELETED slot on the probe sequence of a hash
+    size_t findFirstNonFull(const unsigned long long hv) const
+    {
+        const size_t mask = theCapacity - 1;
+        size_t pos = h1(hv) & mask;
+        size_t step = 0;
+        while (true){
+            unsigned m = Group(ctrl + pos).matchEmptyOrDeleted();
+            if (m != 0)
+                return (pos + __builtin_ctz(m)) & mask;
+
+            step += GROUP_WIDTH;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // moves all data elements into a new table of new_capacity slots, which also drops every DELETED slot
+    void rehash(const size_t new_capacity)
+    {
+        signed char* old_ctrl = ctrl;
+        Slot* old_slots = slots;
+        size_t old_capacity = theCapacity;
+
+        allocate(new_capacity);
+        for (size_t i = 0; i < old_capacity; i++){
+            if (old_ctrl[i] < 0)
+                continue;
+
+            unsigned long long hv = hashKey(old_slots[i].key);
+            size_t index = findFirstNonFull(hv);
+            setCtrl(index, h2(hv));
+            new (slots + index) Slot(std::move(old_slots[i]));
+            old_slots[i].~Slot();
+        }
+        growthLeft -= theSize;
+
+        delete[] old_ctrl;
+        ::operator delete(old_slots);
+    }
+
+    // makes room for one more data element
+    // a table whose load is mostly DELETED slots is cleaned at the same capacity instead of doubled
+    void reserveOne()
+    {
+        if (growthLeft > 0)
+            return;
+
+        if (theSize < maxLoad(theCapacity) / 2)
+            rehash(theCapacity);
+        else
+            rehash(theCapacity * 2);
+    }
+
+    // stores x, which must not be in the table yet, on the probe sequence of its hash
+    template <typename Obj>
+    void insertNew(Obj&& x, const unsigned long long hv)
+    {
+        size_t index = findFirstNonFull(hv);
+        if (ctrl[index] == EMPTY && growthLeft == 0){
+            reserveOne();
+            index = findFirstNonFull(hv);
+        }
+        if (ctrl[index] == EMPTY)
+            growthLeft--;
+
+        new (slots + index) Slot(std::forward<Obj>(x));
+        setCtrl(index, h2(hv));
+        theSize++;
+    }
+
+    // checks if the key is new and then inserts it
+    template <typename Obj>
+    bool insertUnique(Obj&& x)
+    {
+        unsigned long long hv = hashKey(x.key);
+        if (find(x.key, hv) != NOT_FOUND)
+            return false;
+
+        insertNew(std::forward<Obj>(x), hv);
+        return true;
+    }
+
+  public:
+
+    static const size_t MIN_CAPACITY = GROUP_WIDTH;   // the smallest table; one group of slots
+
+    // the default constructor; the capacity is the smallest power of two that holds init_size slots
+    explicit MyFlatHashTable(const size_t init_size = MIN_CAPACITY) :
+        theSize{0},
+        seed{randomSeed()}
+    {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < init_size){
+            capacity *= 2;
+        }
+        allocate(capacity);
+    }
+
+    // the slots are raw memory owned by the table, so it is not copied
+    MyFlatHashTable(const MyFlatHashTable & rhs) = delete;
+    MyFlatHashTable & operator= (const MyFlatHashTable & rhs) = delete;
+
+    ~MyFlatHashTable()
+    {
+        release();
+    }
+
+    // checks if the hash table contains the given key
+    bool contains(const KeyType& key) const
+    {
+        return find(key, hashKey(key)) != NOT_FOUND;
+    }
+
+    // retrieves the data element that has the specified key
+    // returns true if the key is contained in the hash table
+    // return false otherwise
+    bool retrieve(const KeyType& key, HashedObj<KeyType, ValueType>& data) const
+    {
+        size_t index = find(key, hashKey(key));
+        if (index == NOT_FOUND)
+            return false;
+
+        data = slots[index];
+        return true;
+    }
+
+    // inserts the given data element into the hash table (copy)
+    // returns true if the key is not contained in the hash table
+    // return false otherwise
+    bool insert(const HashedObj<KeyType, ValueType>& x)
+    {
+        return insertUnique(x);
+    }
+
+    // inserts the given data element into the hash table (move)
+    bool insert(HashedObj<KeyType, ValueType>&& x)
+    {
+        return insertUnique(std::move(x));
+    }
+
+    // removes the data element that has the key from the hash table
+    // returns true if the key is contained in the hash table
+    // returns false otherwise
+    bool remove(const KeyType& key)
+    {
+        size_t index = find(key, hashKey(key));
+        if (index == NOT_FOUND)
+            return false;
+
+        slots[index].~Slot();
+        theSize--;
+
+        // a slot that no probe ever went past (there is an EMPTY slot within GROUP_WIDTH around it,
+        // on both sides) can become EMPTY again; otherwise it has to stay a DELETED marker
+        const size_t mask = theCapacity - 1;
+        unsigned empty_before = Group(ctrl + ((index - GROUP_WIDTH) & mask)).matchEmpty();
+        unsigned empty_after = Group(ctrl + index).matchEmpty();
+        bool never_full = empty_before != 0 && empty_after != 0 &&
+                          leadingZeros(empty_before) + trailingZeros(empty_after) < GROUP_WIDTH;
+        if (never_full){
+            setCtrl(index, EMPTY);
+            growthLeft++;
+        }
+        else{
+            setCtrl(index, DELETED);
+        }
+
+        // shrink like MyHashTable does once the table is mostly empty
+        if (theCapacity > MIN_CAPACITY && theSize < theCapacity / 8)
+            rehash(theCapacity / 2);
+
+        return true;
+    }
+
+    // returns the number of data elements stored in the hash table
+    size_t size() const
+    {
+        return theSize;
+    }
+
+    // returns the number of slots of the hash table
+    size_t capacity() const
+    {
+        return theCapacity;
+    }
+
+};
+
+
+#endif // __MYFLATHASHTABLE_H__
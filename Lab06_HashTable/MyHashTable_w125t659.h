@@ -4,8 +4,11 @@
 #include <iostream>
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
+#include <random>
 #include <string>
+#include <utility>
 
 #include "MyVector_w125t659.h"
 #include "MyLinkedList_w125t659.h"
@@ -19,19 +22,86 @@ static const long long mersenne_prime = (1 << prime_digits) - 1;  // the Mersenn
 long long fastMersenneModulo(const long long n)
 {
     long long res = n;
-    while(res >= mersenne_prime){
+    // folding mersenne_prime itself gives mersenne_prime again, so stop there and map it to 0 below
+    while(res > mersenne_prime){
         res = (res & mersenne_prime) + (res >> prime_digits);
     }
 
     return res == mersenne_prime ? 0 : res;
 }
 
+// spreads every bit of x over all 64 bits of the result (the splitmix64 finaliser)
+inline unsigned long long mix64(unsigned long long x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// the full 128-bit product of a and b, folded to 64 bits by xor-ing its halves
+inline unsigned long long foldedMultiply(const unsigned long long a, const unsigned long long b)
+{
+    unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    return static_cast<unsigned long long>(r) ^ static_cast<unsigned long long>(r >> 64);
+}
+
+// reads 8 or 4 bytes at p, whatever their alignment
+inline unsigned long long read64(const char* p)
+{
+    unsigned long long v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline unsigned long long read32(const char* p)
+{
+    unsigned int v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// a random seed for the hash function of one table, so that the keys that collide in one table,
+// e.g. keys chosen to make it slow, do not collide in another
+inline unsigned long long randomSeed()
+{
+    std::random_device rd;
+    return (static_cast<unsigned long long>(rd()) << 32) ^ rd();
+}
+
 // definition of the template hash function class
 template <typename KeyType>
 class HashFunc
 {
   public:
     long long univHash(const KeyType key, const long long table_size) const;
+
+    // the full 64-bit hash, not reduced to any table size; used by tables that pick their own bits of it
+    // different seeds give unrelated hashes
+    unsigned long long fullHash(const KeyType key, const unsigned long long seed = 0) const;
+};
+
+// whether HashFunc<KeyType>::fullHash already spreads every bit of the key over all 64 bits, as both
+// built-in ones do; a power-of-two table uses the low bits of such a hash as they are, and mixes any other first
+// a HashFunc for another key type can specialise this when its fullHash ends in a finaliser of its own
+template <typename KeyType>
+struct FullHashMixed
+{
+    static const bool value = false;
+};
+
+template <>
+struct FullHashMixed<long long>
+{
+    static const bool value = true;     // the splitmix64 finaliser
+};
+
+template <>
+struct FullHashMixed<std::string>
+{
+    static const bool value = true;     // the final 128-bit multiplication
 };
 
 // the hash function class that supports the hashing of the "long long" data type
@@ -45,6 +115,11 @@ class HashFunc<long long>
         hv = hv % table_size;
         return hv;
     }
+
+    unsigned long long fullHash(const long long key, const unsigned long long seed = 0) const
+    {
+        return mix64(static_cast<unsigned long long>(key) ^ seed);
+    }
 };
 
 // the has function class that supports the hashing of the "std::string" data type
@@ -57,14 +132,66 @@ class HashFunc<std::string>
     long long univHash(const std::string& key, const long long table_size) const
     {
         long long hv = 0;
+        // reduced as it goes, which gives the same result without overflowing on long keys
         for(size_t i = 0; i < key.length(); ++ i)
         {
-            hv = param_base * hv + static_cast<long long>(key[i]);
+            hv = fastMersenneModulo(param_base * hv + static_cast<long long>(key[i]));
         }
         hv = fastMersenneModulo(static_cast<long long>(uh_param_a * hv + uh_param_b));
         hv = hv % table_size;
         return hv;
     }
+
+    // reads the key 16 bytes at a time and mixes each pair of words with one 64x64->128-bit multiplication
+    // (the scheme of wyhash); keys of up to 16 bytes take a single multiplication before the final one
+    unsigned long long fullHash(const std::string& key, const unsigned long long seed = 0) const
+    {
+        static const unsigned long long p0 = 0xa0761d6478bd642fULL;
+        static const unsigned long long p1 = 0xe7037ed1a0b428dbULL;
+
+        const char* p = key.data();
+        size_t len = key.length();
+        unsigned long long h = seed ^ foldedMultiply(seed ^ p0, p1);
+        unsigned long long a, b;
+
+        if(len <= 16)
+        {
+            if(len >= 4)
+            {
+                // two overlapping pairs of 4-byte reads cover every byte of a 4..16 byte key
+                size_t mid = (len >> 3) << 2;
+                a = (read32(p) << 32) | read32(p + mid);
+                b = (read32(p + len - 4) << 32) | read32(p + len - 4 - mid);
+            }
+            else if(len > 0)
+            {
+                a = (static_cast<unsigned long long>(static_cast<unsigned char>(p[0])) << 16) |
+                    (static_cast<unsigned long long>(static_cast<unsigned char>(p[len >> 1])) << 8) |
+                    static_cast<unsigned char>(p[len - 1]);
+                b = 0;
+            }
+            else
+            {
+                a = b = 0;
+            }
+        }
+        else
+        {
+            size_t i = len;
+            for(; i > 16; i -= 16, p += 16)
+            {
+                h = foldedMultiply(read64(p) ^ p1, read64(p + 8) ^ h);
+            }
+            // the last 16 bytes, which may overlap the ones already read
+            a = read64(p + i - 16);
+            b = read64(p + i - 8);
+        }
+
+        unsigned __int128 r = static_cast<unsigned __int128>(a ^ p1) * (b ^ h);
+        a = static_cast<unsigned long long>(r);
+        b = static_cast<unsigned long long>(r >> 64);
+        return foldedMultiply(a ^ p0 ^ len, b ^ p1);
+    }
 };
 
 // definition of the template hashed object class
@@ -107,14 +234,86 @@ class HashedObj
 
 };
 
+// how MyHashTable sizes its table and maps the hash of a key to a bucket
+enum class TableSizing
+{
+    PRIME,      // prime table sizes; the bucket is (hv % table size), an integer division
+    MASK,       // power-of-two table sizes; the bucket is the low bits of hv
+    FASTRANGE   // power-of-two table sizes; the bucket is the high 64 bits of (hv * table size), Lemire's fastrange
+};
+
 template <typename KeyType, typename ValueType>
 class MyHashTable
 { 
+  private:
+
+    // a data element as the chains hold it: along with the hash of its key,
+    // so that neither a lookup nor a rehash has to hash the key again
+    struct Entry
+    {
+        size_t hv;
+        HashedObj<KeyType, ValueType> obj;
+    };
+
+    typedef MyLinkedList<Entry> Chain;
+
+  public:
+
+    // a data element found in, or just inserted into, the hash table: its chain and its place in that chain
+    // a handle is valid until the table is next resized, i.e. until the next insertion or removal
+    class handle
+    {
+      private:
+        Chain* chain;
+        typename Chain::iterator position;
+        bool found;
+
+        friend class MyHashTable<KeyType, ValueType>;
+
+      public:
+        // a handle to nothing, as returned by find() for a missing key
+        handle() :
+            chain{nullptr},
+            found{false}
+        { }
+
+        // checks if the handle refers to a data element
+        explicit operator bool() const
+        {
+            return found;
+        }
+
+        HashedObj<KeyType, ValueType>& operator*() const
+        {
+            typename Chain::iterator it = position;
+            return (*it).obj;
+        }
+
+        HashedObj<KeyType, ValueType>* operator->() const
+        {
+            return &**this;
+        }
+    };
+
   private:
     size_t theSize; // the number of data elements stored in the hash table
-    MyVector<MyLinkedList<HashedObj<KeyType, ValueType> >* > hash_table;    // the hash table implementing the separate chaining approach
+    MyVector<Chain*> hash_table;    // the hash table implementing the separate chaining approach
     MyVector<size_t> primes;    // a set of precomputed and sorted prime numbers
 
+    // an empty bucket has no chain (nullptr) until something is inserted into it
+    // with rehash_step > 0, a resize keeps the old buckets in old_table and moves migration_step of them
+    // to hash_table per insertion or removal; the old buckets below "migrated" have been moved already
+    size_t rehash_step;
+    size_t migration_step;  // rehash_step, or more if that would not finish before the next resize
+    MyVector<Chain*> old_table;
+    size_t migrated;
+
+    // the chains a rehash emptied, kept for the buckets it fills next rather than freed and allocated again
+    MyVector<Chain*> spare_chains;
+
+    unsigned long long seed;    // the seed of this table's hash function, drawn at random
+    TableSizing sizing;         // the table sizes and the reduction of a hash to a bucket
+
     // pre-calculate a set of primes using the sieve of Eratosthenes algorithm
     // will be called if table doubling requires a larger prime number for table size
     // expected to update the private member "primes"
@@ -152,11 +351,35 @@ class MyHashTable
         // std::cout << "" << std::endl;
     }
 
+    // checks if n is a prime by trial division with the odd numbers up to its square root
+    static bool isPrime(const size_t n)
+    {
+        if (n < 2)
+            return false;
+        if (n % 2 == 0)
+            return n == 2;
+
+        for (size_t d = 3; d * d <= n; d += 2){
+            if (n % d == 0)
+                return false;
+        }
+        return true;
+    }
+
     // finding the smallest prime that is larger than or equal to n
     // should perform binary search against the private member "primes"
     size_t nextPrime(const size_t n)
     {
         // calculate more primes if necessary
+        // a table that rehashes incrementally tries the numbers from n on instead, as a sieve up to 2n
+        // would stall the operation that resizes the table for longer than the rehash itself
+        if ((primes.empty() || primes.back() < n) && rehash_step > 0){
+            size_t p = n;
+            while (!isPrime(p)){
+                p++;
+            }
+            return p;
+        }
         if (primes.empty() || primes.back() < n)
             preCalPrimes(n);
 
@@ -176,57 +399,206 @@ class MyHashTable
         return primes[left];
     }
 
-    // finds the MyLinkedList itertor that corresponds to the hashed object that has the specified key
-    // returns the end() iterator if not found
-    typename MyLinkedList<HashedObj<KeyType, ValueType>>::iterator find(const KeyType& key)
+    // the smallest power of two that is larger than or equal to n
+    static size_t nextPowerOfTwo(const size_t n)
     {
-        size_t index = HashFunc<KeyType>().univHash(key, hash_table.size());
-        auto& list = hash_table[index];
+        size_t p = 1;
+        while (p < n){
+            p *= 2;
+        }
+        return p;
+    }
+
+    // hashes a key once per operation, to the full 64 bits
+    // a power-of-two table only uses some of the bits, so unless FullHashMixed says the HashFunc already did,
+    // they are mixed with all the others first; a HashFunc that leaves those bits alike for many keys would
+    // otherwise fill only a few buckets
+    size_t hashKey(const KeyType& key) const
+    {
+        unsigned long long hv = HashFunc<KeyType>().fullHash(key, seed);
+        return sizing == TableSizing::PRIME || FullHashMixed<KeyType>::value ? hv : mix64(hv);
+    }
+
+    // the bucket of hash hv in a table of the given size
+    size_t bucketIndex(const size_t hv, const size_t table_size) const
+    {
+        switch (sizing){
+          case TableSizing::MASK:
+            return hv & (table_size - 1);
+          case TableSizing::FASTRANGE:
+            return static_cast<size_t>((static_cast<unsigned __int128>(hv) * table_size) >> 64);
+          default:
+            return hv % table_size;
+        }
+    }
+
+    // the bucket that holds the keys of hash hv: the old one while a rehash has not moved it yet
+    Chain*& bucketOf(const size_t hv)
+    {
+        if (!old_table.empty()){
+            size_t index = bucketIndex(hv, old_table.size());
+            if (index >= migrated)
+                return old_table[index];
+        }
+        return hash_table[bucketIndex(hv, hash_table.size())];
+    }
+
+    // finds the data element that has the specified key in the bucket of hash hv
+    // returns a handle to nothing if not found
+    handle find(const KeyType& key, const size_t hv)
+    {
+        handle h;
+        auto list = bucketOf(hv);
+        if (list == nullptr)
+            return h;
 
         for (auto it = list->begin(); it != list->end(); ++it) {
-            if ((*it).key == key) {  // Use *it, which internally calls operator*()
-                return it;
+            // the full hashes of different keys almost never match, so a key is compared about once per lookup
+            if ((*it).hv == hv && (*it).obj.key == key) {
+                h.chain = list;
+                h.position = it;
+                h.found = true;
+                break;
             }
         }
 
-        return list->end();
+        return h;
+    }
+
+    // inserts x, whose key must not be in the table yet, into the bucket of hash hv
+    // the table grows before the insertion rather than after it, so that the returned handle stays valid;
+    // that leaves the same capacity as growing right after it
+    template <typename Obj>
+    handle insertNew(Obj&& x, const size_t hv)
+    {
+        double loadFactor = (static_cast<double>(size() + 1) / capacity());
+        if(loadFactor > 0.5)
+            doubleTable();
+
+        if(capacity() == 7)
+            doubleTable();
+
+        auto& list = bucketOf(hv);
+        if (list == nullptr)
+            list = newChain();
+
+        handle h;
+        h.chain = list;
+        h.position = list->insert(list->end(), Entry{hv, HashedObj<KeyType, ValueType>(std::forward<Obj>(x))});
+        h.found = true;
+
+        theSize++;
+
+        return h;
+    }
+
+    // an empty chain for a bucket: one that a rehash emptied if there is any
+    Chain* newChain()
+    {
+        if (spare_chains.empty())
+            return new Chain();
+
+        Chain* chain = spare_chains.back();
+        spare_chains.pop_back();
+        return chain;
+    }
+
+    // frees the spare chains once a rehash is done with them
+    void freeSpareChains()
+    {
+        for (Chain* chain : spare_chains) {
+            delete chain;
+        }
+        spare_chains = MyVector<Chain*>();
+    }
+
+    // moves the data elements of one chain into the buckets of table by relinking their nodes;
+    // no element is copied, no key is hashed, and the emptied chain is kept for reuse
+    // an incremental rehash keeps no more than one step's worth of spare chains and frees the others
+    // right away; a shrinking table reuses few of them, and freeing them all once the rehash is done
+    // would stall that one operation for as long as the rehash itself
+    void rehashChain(Chain* chain, MyVector<Chain*>& table)
+    {
+        if (chain == nullptr)
+            return;
+
+        while (!chain->empty()) {
+            auto it = chain->begin();
+            Chain*& target = table[bucketIndex((*it).hv, table.size())];
+            if (target == nullptr)
+                target = newChain();
+            target->splice(target->end(), *chain, it);
+        }
+        if (rehash_step > 0 && spare_chains.size() >= migration_step)
+            delete chain;
+        else
+            spare_chains.push_back(chain);
+    }
+
+    // moves up to n more buckets of a rehash in progress to the new table
+    void rehashStep(size_t n)
+    {
+        if (old_table.empty())
+            return;
+
+        for (; n > 0 && migrated < old_table.size(); n--, migrated++) {
+            rehashChain(old_table[migrated], hash_table);
+            old_table[migrated] = nullptr;
+        }
+
+        if (migrated == old_table.size()) {
+            old_table = MyVector<Chain*>();
+            freeSpareChains();
+        }
     }
 
     // rehashes all data elements in the hash table into a new hash table with new_size
     // note that the new_size can be either smaller or larger than the existing size
+    // with rehash_step > 0 this only sets the new table up, and rehashStep() moves the elements over time
     void rehash(const size_t new_size)
     {
-        // Create a new table with the correct size and initialize it
-        MyVector<MyLinkedList<HashedObj<KeyType, ValueType>>*> new_table(new_size);
+        // a rehash still in progress is finished first, so that all the elements are in one table
+        rehashStep(old_table.size());
 
-        // Initialize the new table's linked lists
+        // Create a new table with the correct size; its chains are created as they are needed
+        MyVector<Chain*> new_table(new_size);
         for (size_t i = 0; i < new_size; ++i) {
-            new_table[i] = new MyLinkedList<HashedObj<KeyType, ValueType>>();
+            new_table[i] = nullptr;
         }
 
-        size_t old_size = theSize;
+        if (rehash_step > 0) {
+            old_table = std::move(hash_table);
+            hash_table = std::move(new_table);
+            migrated = 0;
+
+            // the next resize would move whatever is left all at once, so the step has to move every old
+            // bucket within the operations that can come before it, growing or shrinking: after the table
+            // doubles, removing a quarter as many keys as there are old buckets shrinks it again, and after
+            // it halves, removing a sixteenth as many does
+            size_t grow_in = capacity() / 2 > size() ? capacity() / 2 - size() : 0;
+            size_t shrink_in = size() > capacity() / 8 ? size() - capacity() / 8 : 0;
+            size_t operations = std::max<size_t>(std::min(grow_in, shrink_in), 1);
+            migration_step = std::max(rehash_step, (old_table.size() + operations - 1) / operations);
+            return;
+        }
 
         // Rehash all elements into the new table
         for (size_t i = 0; i < hash_table.size(); ++i) {
-            if (hash_table[i]) {
-                for (const auto& item : *hash_table[i]) {
-                    size_t new_index = HashFunc<KeyType>().univHash(item.key, new_size);
-                    new_table[new_index]->push_back(item);
-                }
-                delete hash_table[i];  // Free old memory
-            }
+            rehashChain(hash_table[i], new_table);
         }
 
-        // Assign new table and update the size
+        // Assign new table
         hash_table = std::move(new_table);
-        theSize = old_size;
+        freeSpareChains();
     }
 
     // doubles the size of the table and perform rehashing
     // the new table size should be the smallest prime that is larger than the expected new table size (double of the old size)
+    // a power-of-two table just doubles, without looking for any prime
     void doubleTable()
     {
-        size_t new_size = nextPrime(2 * hash_table.capacity() + 1);
+        size_t new_size = sizing == TableSizing::PRIME ? nextPrime(2 * hash_table.capacity() + 1)
+                                                       : 2 * hash_table.capacity();
         this->rehash(new_size);
     }
 
@@ -234,22 +606,34 @@ class MyHashTable
     // the new table size should be the smallest prime that is larger than the expected new table size (half of the old size)
     void halveTable()
     {
-        size_t new_size = nextPrime(ceil(hash_table.capacity() / 2));
+        size_t new_size = sizing == TableSizing::PRIME ? nextPrime(ceil(hash_table.capacity() / 2))
+                                                       : nextPowerOfTwo(hash_table.capacity() / 2);
         this->rehash(new_size);
     }
 
   public:
 
     // the default constructor; allocate memory if necessary
-    explicit MyHashTable(const size_t init_size = 3)
+    // rehash_step is the number of buckets moved to the new table per insertion or removal while the table
+    // is resized; with 0, a resize rehashes everything at once
+    // a resize moves more buckets per operation where rehash_step would not finish before the next one:
+    // at least 4 after the table doubles, and at least 16 after it halves
+    // sizing picks prime table sizes, or power-of-two ones that never compute a prime or divide by the table size
+    explicit MyHashTable(const size_t init_size = 3, const size_t rehash_step = 0,
+                         const TableSizing sizing = TableSizing::PRIME) :
+        rehash_step{rehash_step},
+        migration_step{rehash_step},
+        migrated{0},
+        seed{randomSeed()},
+        sizing{sizing}
     {
-        size_t table_size = nextPrime(init_size);
+        size_t table_size = sizing == TableSizing::PRIME ? nextPrime(init_size) : nextPowerOfTwo(init_size);
         hash_table.resize(table_size);
 
         theSize = 0;
 
         for (size_t i = 0; i < table_size; ++i) {
-            hash_table[i] = new MyLinkedList<HashedObj<KeyType, ValueType>>();
+            hash_table[i] = nullptr;
         }
     }
 
@@ -259,16 +643,23 @@ class MyHashTable
         for (size_t i = 0; i < hash_table.size(); ++i) {
             delete hash_table[i];  // Free each MyLinkedList object
         }
+        for (size_t i = 0; i < old_table.size(); ++i) {
+            delete old_table[i];
+        }
+        freeSpareChains();
+    }
+
+    // finds the data element that has the specified key, hashing the key once
+    // returns a handle to nothing if the key is not contained in the hash table
+    handle find(const KeyType& key)
+    {
+        return find(key, hashKey(key));
     }
 
     // checks if the hash tabel contains the given key
     bool contains(const KeyType& key)
     {
-        auto it = find(key);
-        size_t index = HashFunc<KeyType>().univHash(key, hash_table.size());
-        bool contained = (it != hash_table[index]->end());
-
-        return contained;
+        return static_cast<bool>(find(key));
     }
 
     // retrieves the data element that has the specified key
@@ -276,10 +667,10 @@ class MyHashTable
     // return false otherwise
     bool retrieve(const KeyType& key, HashedObj<KeyType, ValueType>& data)
     {
-        if(contains(key)){
+        handle h = find(key);
+        if(h){
             // key found; update data and return true
-            auto it = find(key);
-            data = *it;
+            data = *h;
             return true;
         }
 
@@ -292,23 +683,14 @@ class MyHashTable
     // return false otherwise
     bool insert(const HashedObj<KeyType, ValueType>& x)
     {
-        // check redundancy
-        if(contains(x.key))
-            return false;
-        
-        // insert element into hash table
-        size_t index = HashFunc<KeyType>().univHash(x.key, hash_table.size());
-        hash_table[index]->push_back(x);
-
-        theSize++;
+        rehashStep(migration_step);
 
-        double loadFactor = (static_cast<double>(size()) / capacity());
-        if(loadFactor > 0.5)
-            doubleTable();
-
-        if(capacity() == 7)
-            doubleTable();
+        // check redundancy in the bucket the element goes to
+        size_t hv = hashKey(x.key);
+        if(find(x.key, hv))
+            return false;
 
+        insertNew(x, hv);
         return true;
     }
 
@@ -317,53 +699,95 @@ class MyHashTable
     // return false otherwise
     bool insert(HashedObj<KeyType, ValueType> && x)
     {
-        // check redundancy
-        if(contains(x.key))
+        rehashStep(migration_step);
+
+        // check redundancy in the bucket the element goes to
+        size_t hv = hashKey(x.key);
+        if(find(x.key, hv))
             return false;
-        
-        // insert element into hash table
-        size_t index = HashFunc<KeyType>().univHash(x.key, hash_table.size());
-        hash_table[index]->push_back(std::move(x));
 
-        theSize++;
+        insertNew(std::move(x), hv);
+        return true;
+    }
 
+    // inserts a data element with the key and a value constructed from args, unless the key is already contained
+    // returns a handle to the element with the key, and true if it was inserted
+    // args are left untouched if the key is already contained
+    template <typename... Args>
+    std::pair<handle, bool> try_emplace(const KeyType& key, Args&&... args)
+    {
+        rehashStep(migration_step);
 
-        double loadFactor = (static_cast<double>(size()) / capacity());
-        if(loadFactor > 0.5)
-            doubleTable();
+        size_t hv = hashKey(key);
+        handle h = find(key, hv);
+        if(h)
+            return std::make_pair(h, false);
 
-        if(capacity() == 7)
-            doubleTable();
+        HashedObj<KeyType, ValueType> x(KeyType(key), ValueType(std::forward<Args>(args)...));
+        return std::make_pair(insertNew(std::move(x), hv), true);
+    }
 
-        return true;
+    template <typename... Args>
+    std::pair<handle, bool> try_emplace(KeyType&& key, Args&&... args)
+    {
+        rehashStep(migration_step);
+
+        size_t hv = hashKey(key);
+        handle h = find(key, hv);
+        if(h)
+            return std::make_pair(h, false);
+
+        HashedObj<KeyType, ValueType> x(std::move(key), ValueType(std::forward<Args>(args)...));
+        return std::make_pair(insertNew(std::move(x), hv), true);
     }
 
-    // removes the data element that has the key from the hash table
-    // returns true if the key is contained in the hash table
-    // returns false otherwise
-    bool remove(const KeyType& key)
+    // assigns the value to the data element with the key, or inserts one if the key is not contained
+    // returns a handle to the element with the key, and true if it was inserted
+    template <typename Value>
+    std::pair<handle, bool> insert_or_assign(const KeyType& key, Value&& value)
     {
-        // find key's bucket
-        size_t index = HashFunc<KeyType>().univHash(key, hash_table.size());
+        rehashStep(migration_step);
+
+        size_t hv = hashKey(key);
+        handle h = find(key, hv);
+        if(h){
+            h->value = std::forward<Value>(value);
+            return std::make_pair(h, false);
+        }
+
+        HashedObj<KeyType, ValueType> x(KeyType(key), ValueType(std::forward<Value>(value)));
+        return std::make_pair(insertNew(std::move(x), hv), true);
+    }
 
-        // check if key is in list
-        auto it = find(key);
-        if(it == hash_table[index]->end())
-            // key not found
+    // removes the data element that the handle refers to, without hashing or searching again
+    // returns false if the handle refers to nothing
+    bool erase(const handle& h)
+    {
+        if(!h)
             return false;
 
-        // remove key
-        hash_table[index]->erase(it);
-        
+        h.chain->erase(h.position);
+
         theSize--;
 
         double loadFactor = (static_cast<double>(size()) / capacity());
         if(loadFactor < (0.125))
             halveTable();
 
+        // the handle was taken before any bucket moves
+        rehashStep(migration_step);
+
         return true;
     }
 
+    // removes the data element that has the key from the hash table
+    // returns true if the key is contained in the hash table
+    // returns false otherwise
+    bool remove(const KeyType& key)
+    {
+        return erase(find(key));
+    }
+
     // returns the number of data elements stored in the hash table
     size_t size()
     {